@@ -2,55 +2,133 @@
 
 #include "ofMain.h"
 #include "Shape.h"
+#include "FastRandom.h"
+#include "RenderQueue.h"
+#include "EffectsGovernor.h"
+#include "SimulationLod.h"
+#include "MemoryTracker.h"
+#include "GameEvents.h"
 #include <vector>
 #include <random>
-#include "SmallAsteroid.h"
+#include <type_traits>
+
+// Size classes. Everything that differs between asteroid sizes is a
+// constant here and BasicAsteroid<Traits> folds it in at compile time.
+// Split names the class a hit breaks an asteroid into, splitPieces of
+// them at the hit; NoSplit ends the chain.
+//
+struct NoSplit {};
+
+struct SmallAsteroidTraits {
+    static constexpr float minRadius = 15.0f;
+    static constexpr float maxRadius = 30.0f;
+    static constexpr float fixedSpeed = 3.0f;
+    static constexpr float maxRotationSpeed = 2.0f;     // degrees per tick, either way
+    static constexpr float gravityMass = 1.0f;
+
+    static constexpr int explosionParticles = 30;
+    static constexpr float particleSpeed = 2.5f;        // largest initial x or y speed
+    static constexpr float minParticleLifespan = 0.5f;
+    static constexpr float maxExplosionLifespan = 1.2f;
+    static constexpr float minParticleRadius = 0.5f;
+    static constexpr float maxParticleRadius = 1.5f;
+    // Farthest an explosion particle gets from the hit (3.5 px/tick damped by 0.95 plus particle radius)
+    static constexpr float explosionReach = 75.0f;
+
+    static constexpr GameEvent::Size eventSize = GameEvent::SMALL;
+    static constexpr bool requestsSpawn = false;        // a hit asks for a new large asteroid
+    using Split = NoSplit;
+    static constexpr int splitPieces = 0;
+};
+
+struct LargeAsteroidTraits {
+    static constexpr float minRadius = 40.0f;
+    static constexpr float maxRadius = 60.0f;
+    static constexpr float fixedSpeed = 2.0f;
+    static constexpr float maxRotationSpeed = 1.0f;
+    static constexpr float gravityMass = 4.0f;
+
+    static constexpr int explosionParticles = 100;
+    static constexpr float particleSpeed = 5.0f;
+    static constexpr float minParticleLifespan = 1.0f;
+    static constexpr float maxExplosionLifespan = 2.0f;
+    static constexpr float minParticleRadius = 1.0f;
+    static constexpr float maxParticleRadius = 3.0f;
+    // Farthest an explosion particle gets from the hit (7.1 px/tick damped by 0.95 plus particle radius)
+    static constexpr float explosionReach = 145.0f;
+
+    static constexpr GameEvent::Size eventSize = GameEvent::LARGE;
+    static constexpr bool requestsSpawn = true;
+    using Split = SmallAsteroidTraits;
+    static constexpr int splitPieces = 3;
+};
 
-class Asteroid : public Shape {
+template <typename Traits>
+class BasicAsteroid final : public Shape {
 public:
+    static constexpr float minRadius = Traits::minRadius;
+    static constexpr float maxRadius = Traits::maxRadius;
+    static constexpr float maxExplosionLifespan = Traits::maxExplosionLifespan;
+    static constexpr float explosionReach = Traits::explosionReach;
+    static constexpr bool splits = Traits::splitPieces > 0;
+
+    // Blank asteroid for a snapshot restore to fill in
+    BasicAsteroid() {}
+
     // Constructor that generates the asteroid with random line segments
-    Asteroid(glm::vec3 position, int numSides = 10, float minRadius = 40.0f, float maxRadius = 60.0f) {
+    BasicAsteroid(glm::vec3 position, int numSides = 10) {
         this->pos = position;
         this->numSides = numSides;
-        this->minRadius = minRadius;
-        this->maxRadius = maxRadius;
-        velocity = glm::vec3(ofRandom(-1, 1), ofRandom(-1, 1), 0);
+        FastRandom& rng = gameRandom();
+        velocity = glm::vec3(rng.next(-1, 1), rng.next(-1, 1), 0);
         acceleration = glm::vec3(0, 0, 0);
-        rotationSpeed = ofRandom(-1.0f, 1.0f);
+        rotationSpeed = rng.next(-Traits::maxRotationSpeed, Traits::maxRotationSpeed);
         rot = 0;
-        collisionPoint = glm::vec3(0, 0, 0);
         generateLines();
     }
 
-    void draw() override {
+    // Outline and explosion go into the frame's render queue.
+    // The outline is turned by rot once; the original immediate-mode draw
+    // applied rot twice (getTransform() and ofRotateDeg), so asteroids now
+    // spin on screen at rotationSpeed, half as fast as they used to look
+    void draw(RenderQueue& queue) {
+        const Transform2D& t = transform();
         if (!exploded) {
-            ofPushMatrix();
-            ofMultMatrix(getTransform());
-            ofRotateDeg(rot);
-            ofSetColor(255);
-            for (size_t i = 0; i < lines.size(); ++i) {
-                const auto& line = lines[i];
-                ofDrawLine(line.first, line.second);
+            glm::vec3* v = queue.lines(RenderQueue::LAYER_ASTEROIDS, ofColor(255), lines.size() * 2);
+            for (const auto& line : lines) {
+                *v++ = t.apply(line.first);
+                *v++ = t.apply(line.second);
             }
-            ofPopMatrix();
         }
 
-        drawExplosionParticles();
+        drawExplosionParticles(queue);
     }
 
-    void update() {
+    // Steering is drawn in a batch for all asteroids by the caller
+    // ticks > 1 catches up several ticks at once for simulation LOD
+    void update(const glm::vec3& steering, const glm::vec2& worldSize, int ticks = 1) {
         if (!exploded) {
-            glm::vec3 steering = glm::vec3(ofRandom(-0.1, 0.1), ofRandom(-0.1, 0.1), 0);
+            // Forces applied since the last update (gravity mode), then the wander
+            velocity += acceleration;
+            acceleration = glm::vec3(0, 0, 0);
             velocity += steering;
-            float fixedSpeed = 2.0f;
-            velocity = glm::normalize(velocity) * fixedSpeed;
-            pos += velocity;
-            rot += rotationSpeed;
-
-            if (pos.x > ofGetWidth()) pos.x = 0;
-            else if (pos.x < 0) pos.x = ofGetWidth();
-            if (pos.y > ofGetHeight()) pos.y = 0;
-            else if (pos.y < 0) pos.y = ofGetHeight();
+            velocity = glm::normalize(velocity) * Traits::fixedSpeed;
+            pos += velocity * float(ticks);
+            rot += rotationSpeed * float(ticks);
+
+            if (ticks > 1) {
+                // A catch-up step can carry the asteroid well past an edge;
+                // keep the overshoot so it ends up where the missed ticks would have
+                pos.x = wrapCoordinate(pos.x, worldSize.x);
+                pos.y = wrapCoordinate(pos.y, worldSize.y);
+            }
+            else {
+                if (pos.x > worldSize.x) pos.x = 0;
+                else if (pos.x < 0) pos.x = worldSize.x;
+                if (pos.y > worldSize.y) pos.y = 0;
+                else if (pos.y < 0) pos.y = worldSize.y;
+            }
+            moved();
         }
 
         updateExplosionParticles();
@@ -68,67 +146,99 @@ public:
         return maxRadius;
     }
 
-    // Mark where player shot asteroid
-    void addHitPosition(const glm::vec3& hitPos, std::vector<SmallAsteroid>& smallAsteroids) {
-        if (!exploded) {
-            triggerExplosion(hitPos);
-            for (int i = 0; i < 3; i++) {
-                SmallAsteroid newAsteroid(hitPos);
-                smallAsteroids.push_back(newAsteroid);
-            }
-        }
+    float getGravityMass() const {
+        return Traits::gravityMass;
     }
 
-    // Check collision with emitter particle
-    bool checkCollisionWithParticle(const glm::vec3& particlePos) {
-        if (glm::distance(particlePos, pos) < maxRadius) {
-            collisionPoint = particlePos;
-            return true;
+    // Shot at hitPos: explode there; the world adds any split pieces when
+    // it applies the tick's events
+    void hit(const glm::vec3& hitPos) {
+        if (!exploded) triggerExplosion(hitPos);
+        hasBeenHit = true;
+    }
+
+    // The split pieces of an asteroid hit at hitPos, added to pieces
+    template <typename Pieces>
+    static void addPieces(const glm::vec3& hitPos, Pieces& pieces) {
+        static_assert(std::is_same<typename Pieces::value_type, BasicAsteroid<typename Traits::Split>>::value,
+            "pieces go into the list of the size class this one splits into");
+        // Construct the pieces in place rather than copying temporaries
+        pieces.reserve(pieces.size() + Traits::splitPieces);
+        for (int i = 0; i < Traits::splitPieces; i++) {
+            pieces.emplace_back(hitPos);
         }
-        return false;
     }
 
+    // Every particle has faded once the longest lifespan has passed
     bool isExplosionFinished() const {
-        return exploded && explosionParticles.empty();
+        return exploded && explosionAge >= explosionLifetime;
     }
 
     void updateExplosion() {
         updateExplosionParticles();
     }
 
-    void drawExplosion() {
-        drawExplosionParticles();
-    }
-
     bool isExploding() const {
         return exploded;
     }
 
     glm::vec3 getVelocity() const { return velocity; }
     void setVelocity(const glm::vec3& v) { velocity = v; }
-    void setPosition(const glm::vec3& p) { pos = p; }
+    void setPosition(const glm::vec3& p) { pos = p; moved(); }
 
     bool hasBeenHit = false;
+    SimLod lod;
+    uint32_t id = 0;        // stable id for network snapshots, 0 until the world assigns one
+
+    // Circle around everything draw() puts on screen: the outline, or the
+    // explosion once hit; false when nothing is left to draw
+    bool getDrawBounds(glm::vec3& center, float& radius) const {
+        if (!exploded) {
+            center = pos;
+            radius = maxRadius;
+            return true;
+        }
+        center = explosionCenter;
+        radius = explosionReach;
+        return !isExplosionFinished();
+    }
+
+    // Rotation and explosion state the world hash covers (WorldHash.h)
+    template <typename Visitor>
+    void visitState(Visitor& v, const char* entity, int index) const {
+        v.field(entity, index, "rot", rot);
+        v.field(entity, index, "rotationSpeed", rotationSpeed);
+        v.field(entity, index, "explosionAge", explosionAge);
+        v.field(entity, index, "particles", int(explosionParticles.size()));
+        for (const ExplosionParticle& p : explosionParticles) {
+            v.field(entity, index, "particle pos", p.pos);
+            v.field(entity, index, "particle vel", p.vel);
+            v.field(entity, index, "particle lifespan", p.lifespan);
+            v.field(entity, index, "particle age", p.age);
+            v.field(entity, index, "particle radius", p.radius);
+        }
+    }
 
 private:
+    friend class WorldSnapshot;
+    friend class NetSnapshot;       // reads the outline and pose for network states
+
     int numSides;
-    float minRadius, maxRadius;
     std::vector<std::pair<glm::vec3, glm::vec3>> lines;
     glm::vec3 velocity, acceleration;
     float rotationSpeed;
-    float rot;
-    std::vector<glm::vec3> hitPositions;
-    glm::vec3 collisionPoint;
 
     void generateLines() {
+        MemoryScope memoryScope(MemoryTag::SHAPES);
         float angleStep = TWO_PI / numSides;
 
         lines.clear();
-        glm::vec3 lastPoint = glm::vec3(cos(0) * ofRandom(minRadius, maxRadius), sin(0) * ofRandom(minRadius, maxRadius), 0);
+        FastRandom& rng = gameRandom();
+        glm::vec3 lastPoint = glm::vec3(cos(0) * rng.next(minRadius, maxRadius), sin(0) * rng.next(minRadius, maxRadius), 0);
 
         for (int i = 1; i < numSides; ++i) {
             float angle = i * angleStep;
-            float length = ofRandom(minRadius, maxRadius);
+            float length = rng.next(minRadius, maxRadius);
             glm::vec3 newPoint = glm::vec3(cos(angle) * length, sin(angle) * length, 0);
             lines.push_back(std::make_pair(lastPoint, newPoint));
             lastPoint = newPoint;
@@ -148,59 +258,83 @@ private:
 
     bool exploded = false;
     std::vector<ExplosionParticle> explosionParticles;
+    float explosionAge = 0;
+    float explosionLifetime = 0;
+    glm::vec3 explosionCenter;
 
     void triggerExplosion(const glm::vec3& hitPos) {
+        MemoryScope memoryScope(MemoryTag::PARTICLES);
         exploded = true;
+        explosionCenter = hitPos;
         explosionParticles.clear();
+        explosionAge = 0;
+        explosionLifetime = 0;
+
+        // Draw every random value for the burst in one batch
+        const int numParticles = Traits::explosionParticles;
+        float rolls[numParticles * 4];
+        FastRandom& rng = gameRandom();
+        rng.fill(rolls, numParticles * 2, -Traits::particleSpeed, Traits::particleSpeed);
+        rng.fill(rolls + numParticles * 2, numParticles, Traits::minParticleLifespan, maxExplosionLifespan);
+        rng.fill(rolls + numParticles * 3, numParticles, Traits::minParticleRadius, Traits::maxParticleRadius);
+
+        // The whole burst is simulated whatever the effects quality; the
+        // quality only thins out drawExplosionParticles()
+        explosionParticles.reserve(numParticles);
+        for (int i = 0; i < numParticles; i++) {
+            explosionLifetime = std::max(explosionLifetime, rolls[numParticles * 2 + i]);
 
-        for (int i = 0; i < 100; i++) {
             ExplosionParticle p;
             p.pos = hitPos;
-            p.vel = glm::vec3(ofRandom(-5, 5), ofRandom(-5, 5), 0);
-            p.lifespan = ofRandom(1.0f, 2.0f);
+            p.vel = glm::vec3(rolls[i * 2], rolls[i * 2 + 1], 0);
+            p.lifespan = rolls[numParticles * 2 + i];
             p.age = 0;
-            p.radius = ofRandom(1.0f, 3.0f);
+            p.radius = rolls[numParticles * 3 + i];
             explosionParticles.push_back(p);
         }
     }
 
     void updateExplosionParticles() {
         for (auto& p : explosionParticles) {
+            if (p.age > p.lifespan) continue;     // faded, never drawn again
             p.pos += p.vel;
             p.vel *= 0.95f;
             p.age += 1.0f / 60.0f;
         }
 
-        explosionParticles.erase(
-            std::remove_if(
-                explosionParticles.begin(), explosionParticles.end(),
-                [](const ExplosionParticle& p) { return p.age > p.lifespan; }),
-            explosionParticles.end()
-        );
+        // Faded particles stay in place until the despawn timer removes the asteroid
+        if (exploded) explosionAge += 1.0f / 60.0f;
     }
 
-    void drawExplosionParticles() {
-        int segments = 8;  // Number of lines per explosion particle
-        for (auto& p : explosionParticles) {
-            float alpha = ofMap(p.age, 0, p.lifespan, 255, 0);
-            ofSetColor(255, alpha);
+    void drawExplosionParticles(RenderQueue& queue) {
+        // Lower effects quality draws the first part of the burst, with
+        // fewer segments, and fades it out sooner
+        const EffectsQuality& quality = effectsQuality();
+        const int segments = quality.ringSegments;  // Number of lines per explosion particle
+        size_t count = std::max<size_t>(1, size_t(explosionParticles.size() * quality.particleScale + 0.5f));
 
-            float angleStep = TWO_PI / segments;
-            std::vector<glm::vec3> circlePoints;
+        for (size_t k = 0; k < count && k < explosionParticles.size(); ++k) {
+            const ExplosionParticle& p = explosionParticles[k];
+            float shown = p.lifespan * quality.lifespanScale;
+            if (p.age > shown) continue;
 
-            for (int i = 0; i < segments; ++i) {
-                float angle = i * angleStep;
-                float x = p.pos.x + cos(angle) * p.radius;
-                float y = p.pos.y + sin(angle) * p.radius;
-                circlePoints.emplace_back(x, y, 0);
-            }
+            float alpha = ofMap(p.age, 0, shown, 255, 0);
+            glm::vec3* v = queue.lines(RenderQueue::LAYER_EXPLOSIONS, ofColor(255, alpha), segments * 2);
 
-            // Connect the points into a loop
-            for (int i = 0; i < segments; ++i) {
-                glm::vec3 a = circlePoints[i];
-                glm::vec3 b = circlePoints[(i + 1) % segments];
-                ofDrawLine(a, b);
+            // Ring of segments around the particle
+            float angleStep = TWO_PI / segments;
+            glm::vec3 first(p.pos.x + p.radius, p.pos.y, 0);
+            glm::vec3 last = first;
+            for (int i = 1; i <= segments; ++i) {
+                float angle = i * angleStep;
+                glm::vec3 next = i == segments ? first : glm::vec3(p.pos.x + cos(angle) * p.radius, p.pos.y + sin(angle) * p.radius, 0);
+                *v++ = last;
+                *v++ = next;
+                last = next;
             }
         }
     }
 };
+
+using Asteroid = BasicAsteroid<LargeAsteroidTraits>;
+using SmallAsteroid = BasicAsteroid<SmallAsteroidTraits>;
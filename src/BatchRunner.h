@@ -0,0 +1,138 @@
+#pragma once
+
+#include "GameWorld.h"
+#include "InputPolicy.h"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Headless batch of full game sessions for balance tuning.
+//
+// Sessions are independent worlds, handed out to one worker thread per
+// core. Each worker steps its world to the end of the round with the chosen
+// input policy, and the per-session stats are written to a CSV file.
+//
+class BatchRunner {
+public:
+    struct Settings {
+        int sessions = 1000;
+        int threads = 0;                // 0 = one per core
+        uint64_t baseSeed = 1;          // session i uses baseSeed + i
+        std::string policy = "random";
+        std::string csvPath = "batch.csv";
+        float width = 1200;
+        float height = 720;
+
+        // Balance settings copied into every world
+        float roundLength = 120.0f;
+        float fireRate = 0.2f;
+        float bulletLifetime = 4.0f;
+        int minAsteroids = 7;
+        int baseSides = 10;
+        int destroyedPerSide = 10;
+        int stressPopulation = 0;       // endless rounds, stopped after roundLength
+        SimLodSettings lod;
+        bool gravity = false;
+        GameWorld::Steering steering = GameWorld::STEER_FLOW_FIELD;
+        float theta = 0.6f;             // gravity opening angle
+
+        void applyBalance(GameWorld& world) const {
+            world.roundLength = roundLength;
+            world.fireRate = fireRate;
+            world.bulletLifetime = bulletLifetime;
+            world.minAsteroids = minAsteroids;
+            world.baseSides = baseSides;
+            world.destroyedPerSide = destroyedPerSide;
+            world.stressPopulation = stressPopulation;
+            world.lodSettings = lod;
+            world.gravity = gravity;
+            world.steering = steering;
+            world.gravityField.theta = theta;
+        }
+    };
+
+    struct Result {
+        uint64_t seed = 0;
+        int score = 0;
+        int playerDeaths = 0;
+        int asteroidsDestroyed = 0;
+        uint32_t ticks = 0;
+    };
+
+    int run(const Settings& settings) {
+        int threadCount = settings.threads > 0 ? settings.threads : int(std::thread::hardware_concurrency());
+        threadCount = std::max(1, std::min(threadCount, settings.sessions));
+
+        results.assign(settings.sessions, Result());
+        nextSession = 0;
+
+        auto startTime = std::chrono::steady_clock::now();
+        std::vector<std::thread> workers;
+        for (int i = 0; i < threadCount; ++i) {
+            workers.emplace_back([this, &settings] { work(settings); });
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+        if (!writeCsv(settings.csvPath)) {
+            std::cerr << "could not write " << settings.csvPath << std::endl;
+            return 1;
+        }
+
+        double simulatedSeconds = 0;
+        for (const Result& r : results) {
+            simulatedSeconds += double(r.ticks) / TimerWheel::ticksPerSecond;
+        }
+        std::cout << settings.sessions << " sessions on " << threadCount << " threads in " << wallSeconds << " s" << std::endl;
+        std::cout << "throughput: " << simulatedSeconds / std::max(wallSeconds, 1e-9) << " simulated s per wall s" << std::endl;
+        std::cout << "results written to " << settings.csvPath << std::endl;
+        return 0;
+    }
+
+    std::vector<Result> results;
+
+private:
+    std::atomic<int> nextSession{ 0 };
+
+    void work(const Settings& settings) {
+        // One world per thread, restarted for every session it picks up
+        std::unique_ptr<GameWorld> world(new GameWorld());
+        settings.applyBalance(*world);
+        uint32_t maxTicks = TimerWheel::secondsToTicks(settings.roundLength);
+
+        for (int session = nextSession++; session < settings.sessions; session = nextSession++) {
+            uint64_t seed = settings.baseSeed + uint64_t(session);
+            std::unique_ptr<InputPolicy> policy = makeInputPolicy(settings.policy, seed ^ 0x5DEECE66DULL);
+
+            world->start(seed, settings.width, settings.height);
+            while (!world->timesUp && world->tick < maxTicks) {
+                world->step(policy->nextInput(*world));
+            }
+
+            Result& r = results[session];
+            r.seed = seed;
+            r.score = world->score;
+            r.playerDeaths = world->playerDeaths;
+            r.asteroidsDestroyed = world->asteroidsDestroyed;
+            r.ticks = world->tick;
+        }
+    }
+
+    bool writeCsv(const std::string& path) const {
+        std::ofstream file(path);
+        if (!file) return false;
+
+        file << "session,seed,score,deaths,asteroidsDestroyed,ticks\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            file << i << "," << r.seed << "," << r.score << "," << r.playerDeaths << ","
+                << r.asteroidsDestroyed << "," << r.ticks << "\n";
+        }
+        return bool(file);
+    }
+};
@@ -0,0 +1,302 @@
+#pragma once
+
+#include "ofMain.h"
+#include "RenderQueue.h"
+#include "MemoryTracker.h"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Every bullet in flight, in a fixed-capacity ring of parallel arrays: 2D
+// position, velocity, angle and the tick it was fired on. The arrays are
+// sized once when the round starts (reset()) and never grow during play;
+// emit() refuses a bullet when the ring is full, and GameWorld sizes it so
+// that cannot happen at its fire rate and bullet lifetime.
+//
+// Bullets are indexed oldest first. update() moves them all and counts
+// those that left the world or outlived lifetimeTicks in one branch-free
+// loop over each of the ring's one or two contiguous runs, which the
+// compiler vectorizes. Only when some are gone does it compact, keeping
+// firing order and shifting whichever side of the gaps is shorter: the
+// oldest bullets are the ones that expire and usually the ones leaving the
+// world, so most ticks just move the ring's head. Collision passes mark
+// hits with kill() so indices stay put while they walk the bullets, and
+// removeKilled() compacts once at the end.
+//
+class BulletStore {
+public:
+    // Room for at least capacity bullets, each expiring lifetimeTicks after it was fired
+    void reset(size_t capacity, uint32_t lifetimeTicks) {
+        MemoryScope memoryScope(MemoryTag::PARTICLES);
+        size_t slots = 16;
+        while (slots < capacity) slots *= 2;
+        x.assign(slots, 0.0f);
+        y.assign(slots, 0.0f);
+        vx.assign(slots, 0.0f);
+        vy.assign(slots, 0.0f);
+        rot.assign(slots, 0.0f);
+        spawnTick.assign(slots, 0);
+        dead.assign(slots, 0);
+        mask = slots - 1;
+        this->lifetimeTicks = lifetimeTicks;
+        clear();
+    }
+
+    void clear() {
+        head = 0;
+        count = 0;
+        killed = 0;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    size_t capacity() const { return x.size(); }
+
+    // Bullet i, 0 being the oldest
+    glm::vec3 position(size_t i) const { return glm::vec3(x[slot(i)], y[slot(i)], 0); }
+    glm::vec3 velocity(size_t i) const { return glm::vec3(vx[slot(i)], vy[slot(i)], 0); }
+    float angle(size_t i) const { return rot[slot(i)]; }
+    uint32_t firedOn(size_t i) const { return spawnTick[slot(i)]; }
+
+    // Fire from the ship's nose, carrying the ship's velocity; false when full
+    bool emit(glm::vec3 position, float angle, float speed, glm::vec3 playerVelocity, uint32_t tick) {
+        // Direction of bullet
+        float radians = glm::radians(angle);
+        glm::vec3 direction = glm::vec3(cos(radians), sin(radians), 0);
+
+        // Velocity of bullet
+        glm::vec3 velocity = playerVelocity + (direction * speed);
+
+        // Position of bullet
+        glm::vec3 tipOffset = direction * 10;
+        glm::vec3 particlestartPos = position + tipOffset;
+
+        return add(particlestartPos, velocity, angle, tick);
+    }
+
+    // A bullet with a known state (snapshot restore), as the newest; false when full
+    bool add(const glm::vec3& pos, const glm::vec3& vel, float angle, uint32_t firedOn) {
+        if (count == capacity()) return false;
+        size_t s = slot(count++);
+        x[s] = pos.x;
+        y[s] = pos.y;
+        vx[s] = vel.x;
+        vy[s] = vel.y;
+        rot[s] = angle;
+        spawnTick[s] = firedOn;
+        dead[s] = 0;
+        return true;
+    }
+
+    void update(const glm::vec2& worldSize, uint32_t tick) {
+        if (referenceLoops) {
+            updateReference(worldSize, tick);
+            return;
+        }
+
+        float* px = x.data();
+        float* py = y.data();
+        const float* pvx = vx.data();
+        const float* pvy = vy.data();
+        const uint32_t* fired = spawnTick.data();
+        float width = worldSize.x, height = worldSize.y;
+        uint32_t lifetime = lifetimeTicks;
+        auto goneAt = [=](size_t s) {
+            return (px[s] < 0) | (px[s] > width) | (py[s] < 0) | (py[s] > height) | (tick - fired[s] > lifetime);
+        };
+
+        uint32_t expired = 0;
+        forEachRun([&](size_t begin, size_t end) {
+            uint32_t gone = 0;
+            for (size_t s = begin; s < end; ++s) {
+                float nx = px[s] + pvx[s], ny = py[s] + pvy[s];
+                px[s] = nx;
+                py[s] = ny;
+                gone += uint32_t((nx < 0) | (nx > width) | (ny < 0) | (ny > height) | (tick - fired[s] > lifetime));
+            }
+            expired += gone;
+        });
+        if (expired > 0) compact([&](size_t i) { return goneAt(slot(i)) != 0; });
+    }
+
+    // Bullet i hit something; it stays in place until removeKilled()
+    void kill(size_t i) {
+        uint8_t& flag = dead[slot(i)];
+        if (!flag) killed++;
+        flag = 1;
+    }
+
+    bool isDead(size_t i) const { return dead[slot(i)] != 0; }
+
+    void removeKilled() {
+        if (killed == 0) return;
+        if (referenceLoops) {
+            keepIf([this](size_t s) { return dead[s] == 0; });
+            for (uint8_t& flag : dead) flag = 0;
+            killed = 0;
+            return;
+        }
+        uint8_t* flags = dead.data();
+        size_t m = mask, h = head;
+        compact([=](size_t i) {
+            uint8_t& flag = flags[(h + i) & m];
+            bool gone = flag != 0;
+            flag = 0;
+            return gone;
+        });
+        killed = 0;
+    }
+
+    // Every bullet as a short green line, all in one command
+    void draw(RenderQueue& queue) {
+        if (count == 0) return;
+
+        float halfLength = 2.0f;
+        glm::vec3* v = queue.lines(RenderQueue::LAYER_BULLETS, ofColor(0, 255, 0), count * 2);
+        forEachRun([&](size_t begin, size_t end) {
+            for (size_t s = begin; s < end; ++s) {
+                float radians = glm::radians(rot[s]);
+                float hx = cos(radians) * halfLength, hy = sin(radians) * halfLength;
+                *v++ = glm::vec3(x[s] - hx, y[s] - hy, 0);
+                *v++ = glm::vec3(x[s] + hx, y[s] + hy, 0);
+            }
+        });
+    }
+
+    uint32_t lifetimeTicks = 0;
+
+    // Plain one-bullet-at-a-time loops in place of the fused pass and the
+    // run-by-run compaction, for the differential check (--diff)
+    bool referenceLoops = false;
+
+private:
+    std::vector<float> x, y;            // position
+    std::vector<float> vx, vy;          // velocity per tick
+    std::vector<float> rot;             // degrees
+    std::vector<uint32_t> spawnTick;
+    std::vector<uint8_t> dead;          // kill() flags, all clear outside a collision pass
+    size_t mask = 0;                    // capacity - 1, capacity is a power of two
+    size_t head = 0;                    // slot of the oldest bullet
+    size_t count = 0;
+    size_t killed = 0;
+
+    size_t slot(size_t i) const { return (head + i) & mask; }
+
+    void updateReference(const glm::vec2& worldSize, uint32_t tick) {
+        for (size_t i = 0; i < count; ++i) {
+            size_t s = slot(i);
+            x[s] = x[s] + vx[s];
+            y[s] = y[s] + vy[s];
+        }
+        keepIf([&](size_t s) {
+            bool outside = x[s] < 0 || x[s] > worldSize.x || y[s] < 0 || y[s] > worldSize.y;
+            return !outside && tick - spawnTick[s] <= lifetimeTicks;
+        });
+    }
+
+    // Bullets whose slot keep(s) is true, oldest first, copied down one at a time
+    template <typename Keep>
+    void keepIf(Keep keep) {
+        size_t out = 0;
+        for (size_t i = 0; i < count; ++i) {
+            size_t from = slot(i);
+            if (!keep(from)) continue;
+            size_t to = slot(out++);
+            x[to] = x[from];
+            y[to] = y[from];
+            vx[to] = vx[from];
+            vy[to] = vy[from];
+            rot[to] = rot[from];
+            spawnTick[to] = spawnTick[from];
+        }
+        count = out;
+    }
+
+    // The live bullets' slots as at most two runs, oldest first
+    template <typename Fn>
+    void forEachRun(Fn fn) {
+        size_t end = head + count;
+        fn(head, std::min(end, capacity()));
+        if (end > capacity()) fn(size_t(0), end - capacity());
+    }
+
+    // n bullets from index from to index to, a contiguous run of each array at a time
+    void moveRun(size_t from, size_t to, size_t n) {
+        if (from == to) return;
+        while (n > 0) {
+            size_t a, b, len;
+            if (to < from) {
+                // Towards the oldest: the front of the run first
+                a = slot(from);
+                b = slot(to);
+                len = std::min(n, std::min(capacity() - a, capacity() - b));
+                from += len;
+                to += len;
+            }
+            else {
+                // Towards the newest: the back of the run first
+                size_t aEnd = slot(from + n - 1) + 1, bEnd = slot(to + n - 1) + 1;
+                len = std::min(n, std::min(aEnd, bEnd));
+                a = aEnd - len;
+                b = bEnd - len;
+            }
+            copySlots(x, a, b, len);
+            copySlots(y, a, b, len);
+            copySlots(vx, a, b, len);
+            copySlots(vy, a, b, len);
+            copySlots(rot, a, b, len);
+            copySlots(spawnTick, a, b, len);
+            n -= len;
+        }
+    }
+
+    // Overlapping copy; short runs, common when bullets die close together, skip the call
+    template <typename T>
+    static void copySlots(std::vector<T>& v, size_t from, size_t to, size_t len) {
+        T* data = v.data();
+        if (len > 8) std::memmove(data + to, data + from, len * sizeof(T));
+        else if (to < from) for (size_t i = 0; i < len; ++i) data[to + i] = data[from + i];
+        else for (size_t i = len; i-- > 0;) data[to + i] = data[from + i];
+    }
+
+    // Drop every bullet gone(i) is true for, keeping the order of the rest;
+    // gone is asked once per bullet, before that bullet's slot is written.
+    // Survivors older than the first gap or newer than the last stay put
+    // on one side, and the shorter side is the one shifted, run by run.
+    template <typename Gone>
+    void compact(Gone gone) {
+        size_t first = 0;
+        while (first < count && !gone(first)) first++;
+        if (first == count) return;
+        size_t last = count - 1;
+        while (last > first && !gone(last)) last--;
+
+        if (first < count - 1 - last) {
+            // Shift the older bullets up to the last gap and move the head
+            size_t top = last + 1;      // survivors so far are at [top, last]
+            size_t i = last;
+            while (i > 0) {
+                size_t end = i;
+                while (i > 0 && (i - 1 < first || (i - 1 != first && !gone(i - 1)))) i--;
+                moveRun(i, top - (end - i), end - i);
+                top -= end - i;
+                if (i > 0) i--;         // the gap
+            }
+            head = slot(top);
+            count -= top;
+        }
+        else {
+            // Shift the newer bullets down to the first gap
+            size_t out = first;
+            size_t i = first + 1;
+            while (i < count) {
+                size_t begin = i;
+                while (i < count && (i > last || (i != last && !gone(i)))) i++;
+                moveRun(begin, out, i - begin);
+                out += i - begin;
+                i++;                    // the gap
+            }
+            count = out;
+        }
+    }
+};
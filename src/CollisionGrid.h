@@ -0,0 +1,75 @@
+#pragma once
+
+#include "ofMain.h"
+#include <vector>
+#include <algorithm>
+
+// Uniform grid over the world for the collision broadphase.
+//
+// Rebuilt from scratch every tick: items are bucketed by their centre with
+// a counting sort, so a build is two passes over the items and each cell's
+// items sit next to each other in one array. Queries visit every item whose
+// cell overlaps the query circle's bounding square; the caller does the
+// exact test.
+//
+class CollisionGrid {
+public:
+    static const int maxCellsPerSide = 1024;
+
+    void build(const glm::vec2& worldSize, float cellSize, const std::vector<glm::vec3>& centers) {
+        // Very large worlds get bigger cells rather than an unbounded grid
+        this->cellSize = std::max(cellSize, std::max(worldSize.x, worldSize.y) / maxCellsPerSide);
+        cols = std::max(1, int(worldSize.x / this->cellSize) + 1);
+        rows = std::max(1, int(worldSize.y / this->cellSize) + 1);
+
+        cellStart.assign(cols * rows + 1, 0);
+        itemCell.resize(centers.size());
+        for (size_t i = 0; i < centers.size(); ++i) {
+            int cell = cellIndex(centers[i]);
+            itemCell[i] = cell;
+            cellStart[cell + 1]++;
+        }
+        for (int c = 0; c < cols * rows; ++c) {
+            cellStart[c + 1] += cellStart[c];
+        }
+
+        items.resize(centers.size());
+        cursor.assign(cellStart.begin(), cellStart.end() - 1);
+        for (size_t i = 0; i < centers.size(); ++i) {
+            items[cursor[itemCell[i]]++] = int(i);
+        }
+    }
+
+    // Calls visit(index) for every item in the cells touched by the circle
+    template <typename F>
+    void query(const glm::vec3& center, float radius, F&& visit) const {
+        int x0 = clampCol(int((center.x - radius) / cellSize));
+        int x1 = clampCol(int((center.x + radius) / cellSize));
+        int y0 = clampRow(int((center.y - radius) / cellSize));
+        int y1 = clampRow(int((center.y + radius) / cellSize));
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                int cell = y * cols + x;
+                for (int k = cellStart[cell]; k < cellStart[cell + 1]; ++k) {
+                    visit(items[k]);
+                }
+            }
+        }
+    }
+
+private:
+    float cellSize = 1;
+    int cols = 1;
+    int rows = 1;
+    std::vector<int> cellStart;     // items of cell c are items[cellStart[c] .. cellStart[c + 1])
+    std::vector<int> items;
+    std::vector<int> itemCell;
+    std::vector<int> cursor;
+
+    int clampCol(int x) const { return std::min(std::max(x, 0), cols - 1); }
+    int clampRow(int y) const { return std::min(std::max(y, 0), rows - 1); }
+
+    int cellIndex(const glm::vec3& p) const {
+        return clampRow(int(p.y / cellSize)) * cols + clampCol(int(p.x / cellSize));
+    }
+};
@@ -1,64 +1,63 @@
 #pragma once
 
 #include "Asteroid.h"
-#include "SmallAsteroid.h"
 #include "Player.h"
-#include "Emitter.h"
+#include "BulletStore.h"
+#include "GameEvents.h"
+#include "CollisionGrid.h"
+#include "MemoryTracker.h"
 #include <vector>
 #include <algorithm>
+#include <limits>
 
 class CollisionSystem {
 public:
-    // Collision detection between bullet and large asteroid
-    bool BulletLargeAsteroidCollision(std::vector<Emitter>& bullets, std::vector<Asteroid>& asteroids, std::vector<SmallAsteroid>& smallAsteroids) {
-        bool asteroidDestroyed = false;
+    // Result of a nearest asteroid query
+    struct NearestAsteroid {
+        bool found = false;
+        bool small = false;
+        glm::vec3 pos;
+        glm::vec3 velocity;
+        float radius = 0;
+        float distance = 0;     // centre to centre
+    };
+
+    // Closest asteroid to pos that can still be hit, large or small,
+    // measured to its edge so big asteroids count as nearer
+    static NearestAsteroid findNearestAsteroid(const glm::vec3& pos, const std::vector<Asteroid>& asteroids, const std::vector<SmallAsteroid>& smallAsteroids) {
+        NearestAsteroid nearest;
+        float bestEdge = std::numeric_limits<float>::max();
+        findNearest(pos, asteroids, false, nearest, bestEdge);
+        findNearest(pos, smallAsteroids, true, nearest, bestEdge);
+        return nearest;
+    }
 
+    // Collision detection between bullets and one size class of asteroids
+    // Every hit is recorded in events, along with the split and spawn request
+    // for size classes that have them; the world applies them afterwards
+    template <typename Traits>
+    void BulletAsteroidCollision(BulletStore& bullets, std::vector<BasicAsteroid<Traits>>& asteroids, GameEventQueue& events) {
         for (int i = asteroids.size() - 1; i >= 0; --i) {
-            Asteroid& asteroid = asteroids[i];
+            BasicAsteroid<Traits>& asteroid = asteroids[i];
 
             if (asteroid.hasBeenHit) continue;  // Skip if already hit
 
-            for (int j = bullets.size() - 1; j >= 0; --j) {
-                // Check distance directly in the loop
-                if (glm::distance(bullets[j].pos, asteroid.getPosition()) < asteroid.getRadius()) {
-                    glm::vec3 hitPosition = bullets[j].pos;
-                    asteroid.addHitPosition(hitPosition, smallAsteroids);
-                    asteroid.hasBeenHit = true;  // Mark as hit
-                    bullets.erase(bullets.begin() + j);  // Remove the bullet
-                    asteroidDestroyed = true;
-                    break;  // Stop checking other bullets
-                }
-            }
-        }
-        return asteroidDestroyed;
-    }
-
-    // Collision detection between bullet and small asteroid
-    bool BulletSmallAsteroidCollision(std::vector<Emitter>& bullets, std::vector<SmallAsteroid>& smallAsteroids) {
-        bool asteroidDestroyed = false;
-
-        for (int i = smallAsteroids.size() - 1; i >= 0; --i) {
-            SmallAsteroid& smallAsteroid = smallAsteroids[i];
-
-            if (smallAsteroid.hasBeenHit) continue;  // Skip if already hit
-
-            for (int j = bullets.size() - 1; j >= 0; --j) {
+            for (int j = int(bullets.size()) - 1; j >= 0; --j) {
+                if (bullets.isDead(j)) continue;
                 // Check distance directly in the loop
-                if (glm::distance(bullets[j].pos, smallAsteroid.getPosition()) < smallAsteroid.getRadius()) {
-                    glm::vec3 hitPosition = bullets[j].pos;
-                    smallAsteroid.asteroidDestoryed(hitPosition);
-                    smallAsteroid.hasBeenHit = true;  // Mark as hit
-                    bullets.erase(bullets.begin() + j);  // Remove the bullet
-                    asteroidDestroyed = true;
+                glm::vec3 bulletPos = bullets.position(j);
+                if (canHit(asteroid, bulletPos)) {
+                    hitAsteroid(asteroid, bulletPos, events);
+                    bullets.kill(j);  // Remove the bullet once every asteroid is checked
                     break;  // Stop checking other bullets
                 }
             }
         }
-        return asteroidDestroyed;
+        bullets.removeKilled();
     }
 
     // Handle asteroid-to-asteroid collisions (large vs large)
-    static void LargeAsteroidCollision(std::vector<Asteroid>& asteroids) {
+    void LargeAsteroidCollision(std::vector<Asteroid>& asteroids) {
         for (int i = 0; i < asteroids.size(); ++i) {
             for (int j = i + 1; j < asteroids.size(); ++j) {
                 handleCollision(asteroids[i], asteroids[j]);
@@ -67,7 +66,7 @@ public:
     }
 
     // Handle asteroid-to-small asteroid collisions (large vs small)
-    static void LargeSmallAsteroidCollision(std::vector<Asteroid>& asteroids, std::vector<SmallAsteroid>& smallAsteroids) {
+    void LargeSmallAsteroidCollision(std::vector<Asteroid>& asteroids, std::vector<SmallAsteroid>& smallAsteroids) {
         for (int i = 0; i < asteroids.size(); ++i) {
             for (int j = 0; j < smallAsteroids.size(); ++j) {
                 handleCollision(asteroids[i], smallAsteroids[j]);
@@ -75,30 +74,155 @@ public:
         }
     }
 
-    bool CollisionSystem::PlayerLargeAsteroidCollision(Player& player, std::vector<Asteroid>& asteroids) {
-        for (Asteroid& asteroid : asteroids) {
-            if (!player.isExploding && !asteroid.isExploding() && !player.invulnerable && player.checkCollision(asteroid.getPosition(), asteroid.getRadius())) {
+    // Player crashing into one size class of asteroids
+    template <typename Traits>
+    void PlayerAsteroidCollision(Player& player, std::vector<BasicAsteroid<Traits>>& asteroids, GameEventQueue& events) {
+        for (BasicAsteroid<Traits>& asteroid : asteroids) {
+            if (!player.isExploding && !player.invulnerable && touches(player, asteroid)) {
                 player.playerHit();
-                return true;    // Player has been hit
+                events.playerDeath(player.pos);
+                return;         // Player has been hit
             }
         }
-        return false;           // Player has not been hit
     }
 
-    bool CollisionSystem::PlayerSmallAsteroidCollision(Player& player, std::vector<SmallAsteroid>& smallAsteroids) {
-        for (SmallAsteroid& smallAsteroid : smallAsteroids) {
-            if (!player.isExploding && !smallAsteroid.isExploding() && !player.invulnerable && player.checkCollision(smallAsteroid.getPosition(), smallAsteroid.getRadius())) {
-                player.playerHit();
-                return true;    // Player has been hit
+    // Broadphase versions of the checks above for crowded worlds. Same
+    // rules, but each test only looks at nearby cells of a grid built once
+    // per tick from the asteroid centres; large asteroids come first in the
+    // grid's index space, small ones after them.
+    void buildGrid(const std::vector<Asteroid>& asteroids, const std::vector<SmallAsteroid>& smallAsteroids, const glm::vec2& worldSize) {
+        MemoryScope memoryScope(MemoryTag::COLLISION);
+        numLarge = asteroids.size();
+        centers.clear();
+        for (const Asteroid& asteroid : asteroids) centers.push_back(asteroid.getPosition());
+        for (const SmallAsteroid& smallAsteroid : smallAsteroids) centers.push_back(smallAsteroid.getPosition());
+        grid.build(worldSize, Asteroid::maxRadius * 2, centers);
+        candidates.reserve(centers.size());
+    }
+
+    // Each bullet hits the lowest-index asteroid it touches and asteroid i
+    // bounces off its neighbours in index order, so the result does not
+    // depend on the grid's cell order and matches a brute-force pass
+    void BulletAsteroidCollisionGrid(BulletStore& bullets, std::vector<Asteroid>& asteroids, std::vector<SmallAsteroid>& smallAsteroids, GameEventQueue& events) {
+        for (int j = int(bullets.size()) - 1; j >= 0; --j) {
+            glm::vec3 hitPosition = bullets.position(j);
+            int hit = -1;
+            for (int k : nearby(hitPosition, Asteroid::maxRadius)) {
+                if (size_t(k) < numLarge ? canHit(asteroids[k], hitPosition) : canHit(smallAsteroids[k - numLarge], hitPosition)) {
+                    hit = k;
+                    break;
+                }
+            }
+            if (hit < 0) continue;
+
+            if (size_t(hit) < numLarge) hitAsteroid(asteroids[hit], hitPosition, events);
+            else hitAsteroid(smallAsteroids[hit - numLarge], hitPosition, events);
+            bullets.kill(j);
+        }
+        bullets.removeKilled();
+    }
+
+    void PlayerAsteroidCollisionGrid(Player& player, std::vector<Asteroid>& asteroids, std::vector<SmallAsteroid>& smallAsteroids, GameEventQueue& events) {
+        if (player.isExploding || player.invulnerable) return;
+
+        bool hit = false;
+        for (int k : nearby(player.pos, player.getRadius() + Asteroid::maxRadius)) {
+            hit = size_t(k) < numLarge ? touches(player, asteroids[k]) : touches(player, smallAsteroids[k - numLarge]);
+            if (hit) break;
+        }
+        if (hit) {
+            player.playerHit();
+            events.playerDeath(player.pos);
+        }
+    }
+
+    // Large vs large and large vs small bounces; small asteroids pass through each other as before
+    void AsteroidCollisionGrid(std::vector<Asteroid>& asteroids, std::vector<SmallAsteroid>& smallAsteroids) {
+        for (size_t i = 0; i < numLarge; ++i) {
+            if (!asteroids[i].lod.isFull()) continue;   // reduced LOD, no bounces to look for
+            for (int k : nearby(centers[i], Asteroid::maxRadius * 2)) {
+                if (size_t(k) < numLarge) {
+                    if (size_t(k) > i) handleCollision(asteroids[i], asteroids[k]);
+                }
+                else {
+                    handleCollision(asteroids[i], smallAsteroids[k - numLarge]);
+                }
             }
         }
-        return false;           // Player has not been hit
     }
 
+    // The grid passes above visit every asteroid instead of the grid's
+    // nearby cells; the brute-force reference for the differential check
+    bool bruteForce = false;
+
+    // Pairs of a full-rate asteroid with a reduced-LOD neighbour left unresolved;
+    // the grid pass does not even look for neighbours of reduced asteroids
+    int lodSkippedPairs = 0;
+
 private:
+    CollisionGrid grid;
+    std::vector<glm::vec3> centers;
+    size_t numLarge = 0;
+    std::vector<int> candidates;
+
+    // Grid indices that may be within radius of center, ascending; every index when bruteForce
+    const std::vector<int>& nearby(const glm::vec3& center, float radius) {
+        candidates.clear();
+        if (bruteForce) {
+            for (int k = 0; k < int(centers.size()); ++k) candidates.push_back(k);
+        }
+        else {
+            grid.query(center, radius, [this](int k) { candidates.push_back(k); });
+            std::sort(candidates.begin(), candidates.end());
+        }
+        return candidates;
+    }
+
+    // A bullet at pos hits the asteroid
+    template <typename Traits>
+    static bool canHit(const BasicAsteroid<Traits>& asteroid, const glm::vec3& pos) {
+        return !asteroid.hasBeenHit && glm::distance(pos, asteroid.getPosition()) < asteroid.getRadius();
+    }
+
+    template <typename Traits>
+    static bool touches(Player& player, const BasicAsteroid<Traits>& asteroid) {
+        return !asteroid.isExploding() && player.checkCollision(asteroid.getPosition(), asteroid.getRadius());
+    }
+
+    template <typename Traits>
+    static void hitAsteroid(BasicAsteroid<Traits>& asteroid, const glm::vec3& hitPosition, GameEventQueue& events) {
+        asteroid.hit(hitPosition);
+        events.hit(Traits::eventSize, hitPosition);
+        if (Traits::splitPieces > 0) events.split(hitPosition, Traits::splitPieces);
+        if (Traits::requestsSpawn) events.spawnRequest();
+    }
+
+    template <typename T>
+    static void findNearest(const glm::vec3& pos, const std::vector<T>& list, bool small, NearestAsteroid& nearest, float& bestEdge) {
+        for (const T& asteroid : list) {
+            if (asteroid.hasBeenHit || asteroid.isExploding()) continue;
+
+            float distance = glm::distance(pos, asteroid.getPosition());
+            float edge = distance - asteroid.getRadius();
+            if (edge < bestEdge) {
+                bestEdge = edge;
+                nearest.found = true;
+                nearest.small = small;
+                nearest.pos = asteroid.getPosition();
+                nearest.velocity = asteroid.getVelocity();
+                nearest.radius = asteroid.getRadius();
+                nearest.distance = distance;
+            }
+        }
+    }
+
     // Collision detection handling between two asteroids
     template <typename T1, typename T2>
-    static void handleCollision(T1& obj1, T2& obj2) {
+    void handleCollision(T1& obj1, T2& obj2) {
+        if (!obj1.lod.isFull() || !obj2.lod.isFull()) {
+            lodSkippedPairs++;
+            return;
+        }
         if (!obj1.isExploding() && !obj2.isExploding()) {
             glm::vec3 dir = obj1.getPosition() - obj2.getPosition();
             float dist = glm::length(dir);
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "ofMain.h"
+#include <algorithm>
+
+// Picks the gameplay layer's render scale from what drawing it costs.
+//
+// The cost fed in is the gameplay layer's measured render time: the CPU
+// time spent drawing it, or the GPU time from a GpuTimer when that is
+// larger, since the fill-rate-bound cabinets are the ones that miss their
+// budget. It is not the frame interval, which vsync and the display hold
+// at 16.7 ms or more whatever the drawing costs. The cost is smoothed, and
+// the scale only moves after holdFrames frames on the same side of the
+// budget. Above the budget it drops a step; well under it, it climbs back
+// a step.
+//
+class DynamicResolution {
+public:
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+    float step = 0.05f;
+    float budget = 0.010f;          // seconds of gameplay rendering per frame, the rest is update and HUD
+    float headroom = 0.8f;          // grow again once rendering takes less than this much of the budget
+    int holdFrames = 30;
+
+    // Feed the last frame's render time; returns the scale for the next one
+    float update(float renderSeconds) {
+        smoothed = smoothed <= 0 ? renderSeconds : smoothed * 0.9f + renderSeconds * 0.1f;
+
+        int direction = 0;
+        if (smoothed > budget) direction = -1;
+        else if (smoothed < budget * headroom) direction = 1;
+
+        frames = direction == lastDirection ? frames + 1 : 0;
+        lastDirection = direction;
+        if (direction != 0 && frames >= holdFrames) {
+            scale = std::min(maxScale, std::max(minScale, scale + direction * step));
+            frames = 0;
+        }
+        return scale;
+    }
+
+    float scale = 1.0f;
+    float smoothed = 0;             // recent render time in seconds
+
+private:
+    int lastDirection = 0;
+    int frames = 0;
+};
+
+// GPU time of a span of draw calls, from GL timer queries.
+//
+// Results arrive a frame or two late, so a few queries take turns; a query
+// whose result is not ready when its turn comes round again is skipped
+// rather than waited for. Timer queries are not part of OpenGL ES, where
+// seconds stays 0 and the CPU time is used alone.
+//
+class GpuTimer {
+public:
+    ~GpuTimer() {
+#ifndef TARGET_OPENGLES
+        if (created) glDeleteQueries(numQueries, queries);
+#endif
+    }
+
+    void begin() {
+#ifndef TARGET_OPENGLES
+        if (!created) {
+            glGenQueries(numQueries, queries);
+            created = true;
+        }
+        // Collect this slot's last result before reusing it
+        if (pending[slot]) {
+            GLint available = 0;
+            glGetQueryObjectiv(queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) return;
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(queries[slot], GL_QUERY_RESULT, &ns);
+            seconds = float(ns * 1e-9);
+            pending[slot] = false;
+        }
+        glBeginQuery(GL_TIME_ELAPSED, queries[slot]);
+        timing = true;
+#endif
+    }
+
+    void end() {
+#ifndef TARGET_OPENGLES
+        if (!timing) return;
+        glEndQuery(GL_TIME_ELAPSED);
+        pending[slot] = true;
+        slot = (slot + 1) % numQueries;
+        timing = false;
+#endif
+    }
+
+    float seconds = 0;              // latest GPU time measured, 0 until one arrives
+
+private:
+    static const int numQueries = 3;
+#ifndef TARGET_OPENGLES
+    GLuint queries[numQueries] = {};
+#endif
+    bool pending[numQueries] = {};
+    bool created = false;
+    bool timing = false;
+    int slot = 0;
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <algorithm>
+
+// Detail level for cosmetic effects (explosion particles).
+//
+// Lower levels draw fewer of each explosion's particles, with fewer ring
+// segments, and fade them out sooner. Particles are always spawned and
+// moved in full, so the world state, its hash, snapshots and replays never
+// depend on the level; only drawing does.
+//
+struct EffectsQuality {
+    float particleScale = 1.0f;     // fraction of each explosion's particles drawn
+    int ringSegments = 8;           // line segments per particle ring
+    float lifespanScale = 1.0f;     // fraction of each particle's lifespan it is drawn for
+};
+
+// Quality used by the explosion drawing on this thread; the app's governor
+// sets it once a frame, headless runs keep full quality
+inline EffectsQuality& effectsQuality() {
+    thread_local EffectsQuality quality;
+    return quality;
+}
+
+// Picks the effects quality level from recent update and draw times.
+//
+// Over budget for a few frames drops a level straight away; getting back up
+// takes a long run of frames with headroom, so the level does not flicker
+// and a burst of explosions degrades detail instead of stuttering.
+//
+class EffectsGovernor {
+public:
+    static const int numLevels = 5;
+
+    float budget = 1.0f / 60.0f;    // seconds of update + draw per frame
+    float headroom = 0.7f;          // climb once frames take less than this much of the budget
+    int dropFrames = 5;
+    int climbFrames = 120;
+
+    // Feed the last frame's update and draw time; returns the quality to use
+    const EffectsQuality& update(float updateSeconds, float drawSeconds) {
+        float frame = updateSeconds + drawSeconds;
+        smoothed = smoothed <= 0 ? frame : smoothed * 0.8f + frame * 0.2f;
+
+        if (smoothed > budget) {
+            overFrames++;
+            underFrames = 0;
+        }
+        else if (smoothed < budget * headroom) {
+            underFrames++;
+            overFrames = 0;
+        }
+        else {
+            overFrames = 0;
+            underFrames = 0;
+        }
+
+        if (overFrames >= dropFrames && level > 0) {
+            level--;
+            overFrames = 0;
+        }
+        else if (underFrames >= climbFrames && level < numLevels - 1) {
+            level++;
+            underFrames = 0;
+        }
+        return quality();
+    }
+
+    const EffectsQuality& quality() const {
+        static const EffectsQuality levels[numLevels] = {
+            { 0.15f, 4, 0.4f },
+            { 0.3f, 5, 0.55f },
+            { 0.5f, 6, 0.7f },
+            { 0.75f, 8, 0.85f },
+            { 1.0f, 8, 1.0f }
+        };
+        return levels[level];
+    }
+
+    int level = numLevels - 1;      // 0 = lowest detail
+    float smoothed = 0;             // recent update + draw time in seconds
+
+private:
+    int overFrames = 0;
+    int underFrames = 0;
+};
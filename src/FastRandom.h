@@ -0,0 +1,204 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FAST_RANDOM_SSE2 1
+#endif
+
+// Batch random number generator used by the per-frame gameplay paths
+// (asteroid steering, explosion particles) instead of ofRandom.
+//
+// It runs four xoshiro128+ generators side by side, one per SSE2 lane, so
+// every step produces four floats at once. Draws are buffered a block at a
+// time, so the sequence is the same no matter how the calls are split up,
+// and the scalar path produces the exact same numbers as the SSE2 path.
+//
+class FastRandom {
+public:
+    FastRandom(uint64_t seed = 0x853c49e6748fea9bULL) {
+        setSeed(seed);
+    }
+
+    void setSeed(uint64_t seed) {
+        // Expand the seed into the 16 lane words with splitmix64
+        uint64_t x = seed;
+        for (int i = 0; i < 4; ++i) {
+            for (int lane = 0; lane < 4; lane += 2) {
+                uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+                z = z ^ (z >> 31);
+                state[i][lane] = uint32_t(z);
+                state[i][lane + 1] = uint32_t(z >> 32) | 1u;  // never all-zero
+            }
+        }
+        buffered = 4;
+    }
+
+    // Uniform float in [lo, hi)
+    float next(float lo, float hi) {
+        if (buffered == 4) {
+            nextBlock(block);
+            buffered = 0;
+        }
+        return lo + (hi - lo) * block[buffered++];
+    }
+
+    // Fill out[0..count) with uniform floats in [lo, hi)
+    void fill(float* out, size_t count, float lo, float hi) {
+        // The scalar reference draws them one at a time
+        if (!vectorized) {
+            for (size_t i = 0; i < count; ++i) out[i] = next(lo, hi);
+            return;
+        }
+
+        float range = hi - lo;
+        size_t i = 0;
+
+        // Use up what is left of the current block first
+        while (buffered < 4 && i < count) {
+            out[i++] = lo + range * block[buffered++];
+        }
+
+        // Whole blocks straight into the output
+        for (; i + 4 <= count; i += 4) {
+            nextBlock(out + i);
+            for (int k = 0; k < 4; ++k) {
+                out[i + k] = lo + range * out[i + k];
+            }
+        }
+
+        // Tail comes from a fresh buffered block
+        while (i < count) {
+            out[i++] = next(lo, hi);
+        }
+    }
+
+    // Use the SSE2 lanes and block fills when available; off runs the scalar
+    // reference code, one value at a time
+    void setVectorized(bool enabled) { vectorized = enabled; }
+    bool isVectorized() const { return vectorized; }
+
+    // Raw generator state, used to save and restore the stream
+    struct State {
+        uint32_t words[4][4];
+        float block[4];
+        int buffered;
+    };
+
+    State getState() const {
+        State s;
+        for (int i = 0; i < 4; ++i) {
+            for (int lane = 0; lane < 4; ++lane) s.words[i][lane] = state[i][lane];
+            s.block[i] = block[i];
+        }
+        s.buffered = buffered;
+        return s;
+    }
+
+    void setState(const State& s) {
+        for (int i = 0; i < 4; ++i) {
+            for (int lane = 0; lane < 4; ++lane) state[i][lane] = s.words[i][lane];
+            block[i] = s.block[i];
+        }
+        buffered = s.buffered;
+    }
+
+private:
+    // state[word][lane]: four xoshiro128+ generators interleaved
+    alignas(16) uint32_t state[4][4];
+    alignas(16) float block[4] = { 0, 0, 0, 0 };
+    int buffered = 4;
+    bool vectorized = true;
+
+    // Advance all four lanes and write four floats in [0, 1)
+    void nextBlock(float* out) {
+#ifdef FAST_RANDOM_SSE2
+        if (vectorized) {
+            nextBlockSSE2(out);
+            return;
+        }
+#endif
+        for (int lane = 0; lane < 4; ++lane) {
+            uint32_t s0 = state[0][lane], s1 = state[1][lane];
+            uint32_t s2 = state[2][lane], s3 = state[3][lane];
+
+            uint32_t result = s0 + s3;
+            uint32_t t = s1 << 9;
+
+            s2 ^= s0;
+            s3 ^= s1;
+            s1 ^= s2;
+            s0 ^= s3;
+            s2 ^= t;
+            s3 = (s3 << 11) | (s3 >> 21);
+
+            state[0][lane] = s0;
+            state[1][lane] = s1;
+            state[2][lane] = s2;
+            state[3][lane] = s3;
+
+            out[lane] = float(result >> 8) * (1.0f / 16777216.0f);
+        }
+    }
+
+#ifdef FAST_RANDOM_SSE2
+    // Same steps as the scalar loop, all four lanes at once
+    void nextBlockSSE2(float* out) {
+        __m128i s0 = _mm_load_si128((const __m128i*)state[0]);
+        __m128i s1 = _mm_load_si128((const __m128i*)state[1]);
+        __m128i s2 = _mm_load_si128((const __m128i*)state[2]);
+        __m128i s3 = _mm_load_si128((const __m128i*)state[3]);
+
+        __m128i result = _mm_add_epi32(s0, s3);
+        __m128i t = _mm_slli_epi32(s1, 9);
+
+        s2 = _mm_xor_si128(s2, s0);
+        s3 = _mm_xor_si128(s3, s1);
+        s1 = _mm_xor_si128(s1, s2);
+        s0 = _mm_xor_si128(s0, s3);
+        s2 = _mm_xor_si128(s2, t);
+        s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+
+        _mm_store_si128((__m128i*)state[0], s0);
+        _mm_store_si128((__m128i*)state[1], s1);
+        _mm_store_si128((__m128i*)state[2], s2);
+        _mm_store_si128((__m128i*)state[3], s3);
+
+        // Top 24 bits -> float in [0, 1)
+        __m128 f = _mm_cvtepi32_ps(_mm_srli_epi32(result, 8));
+        _mm_storeu_ps(out, _mm_mul_ps(f, _mm_set1_ps(1.0f / 16777216.0f)));
+    }
+#endif
+};
+
+// Generator installed for the gameplay code on this thread, see GameRandomScope
+inline FastRandom*& currentGameRandom() {
+    thread_local FastRandom* current = nullptr;
+    return current;
+}
+
+// Generator used by the gameplay code (steering, explosions, spawning)
+inline FastRandom& gameRandom() {
+    thread_local FastRandom fallback;
+    FastRandom* current = currentGameRandom();
+    return current ? *current : fallback;
+}
+
+// Routes gameRandom() to a world's own generator while it simulates, so
+// each world draws a reproducible stream from its seed
+class GameRandomScope {
+public:
+    GameRandomScope(FastRandom& rng) : previous(currentGameRandom()) {
+        currentGameRandom() = &rng;
+    }
+    ~GameRandomScope() {
+        currentGameRandom() = previous;
+    }
+
+private:
+    FastRandom* previous;
+};
@@ -0,0 +1,202 @@
+#pragma once
+
+#include "ofMain.h"
+#include "GameWorld.h"
+#include "WorldSnapshot.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <string>
+#include <vector>
+
+// Keeps the last windowFrames frames of per-phase timings, entity counts,
+// events and input in memory, and dumps them with a world snapshot when a
+// frame's update or draw goes over budgetMs.
+//
+// The game calls beginFrame() before its update, lap() after each phase
+// (afterStep() after each world tick) and endFrame() once the frame is
+// drawn. Lap times run from the previous lap or mark(), so phases need no
+// start call. A dump writes <directory>/spike-<tick>.csv, oldest frame
+// first and the spike last, and spike-<tick>.snap; dumps closer together
+// than cooldownSeconds are skipped and counted, so a stall that lasts
+// several frames gives one dump.
+//
+// The spike frame only copies the window and captures the snapshot into
+// memory; a worker thread writes both files and then deletes the oldest
+// dumps in the directory beyond maxDumps. A spike while the last dump is
+// still being written is skipped like one inside the cooldown.
+//
+class FlightRecorder {
+public:
+    enum Phase {
+        STEP,           // world ticks, including reading replay input
+        SOUNDS,
+        TELEMETRY,
+        DRAW_WORLD,
+        DRAW_HUD,
+        NUM_PHASES
+    };
+
+    float budgetMs = 20.0f;         // update or draw longer than this is a spike, 0 turns dumps off
+    int windowFrames = 300;         // about five seconds at 60 fps
+    float cooldownSeconds = 10.0f;
+    int maxDumps = 20;              // dumps kept in the directory, oldest deleted first
+    std::string directory;          // where dumps go, created on the first one
+
+    int dumps = 0;
+    int skipped = 0;                // spikes inside the cooldown or during a write
+    int failed = 0;                 // dumps the worker could not write
+    std::string lastDump;           // path of the last snapshot started
+
+    void beginFrame() {
+        if (int(frames.size()) != windowFrames) {
+            frames.assign(std::max(1, windowFrames), Frame());
+            next = 0;
+            filled = 0;
+        }
+        current = Frame();
+        mark();
+    }
+
+    // Start of the next phase without recording the time since the last lap
+    void mark() {
+        lapStart = std::chrono::steady_clock::now();
+    }
+
+    void lap(Phase phase) {
+        auto now = std::chrono::steady_clock::now();
+        current.phaseMs[phase] += std::chrono::duration<float, std::milli>(now - lapStart).count();
+        lapStart = now;
+    }
+
+    // After each world tick: its time, input and events
+    void afterStep(const GameWorld& world, uint8_t input) {
+        lap(STEP);
+        current.ticks++;
+        current.tick = world.tick;
+        current.input |= input;
+        for (const GameEvent& e : world.events) {
+            if (e.type == GameEvent::ASTEROID_HIT) current.hits++;
+            else if (e.type == GameEvent::ASTEROID_SPLIT) current.splits++;
+            else if (e.type == GameEvent::SPAWN_REQUEST) current.spawns++;
+            else if (e.type == GameEvent::SHOT) current.shots++;
+            else if (e.type == GameEvent::PLAYER_DEATH) current.deaths++;
+        }
+    }
+
+    // Closes the frame; true if it went over budget and a dump was started.
+    // effectsLevel is the effects governor's level for the frame
+    bool endFrame(const GameWorld& world, float updateMs, float frameMs, int effectsLevel) {
+        current.updateMs = updateMs;
+        current.drawMs = current.phaseMs[DRAW_WORLD] + current.phaseMs[DRAW_HUD];
+        current.frameMs = frameMs;
+        current.asteroids = int(world.asteroids.size());
+        current.smallAsteroids = int(world.smallAsteroids.size());
+        current.bullets = int(world.bullets.size());
+        current.renderCommands = world.renderQueue.stats.commands;
+        current.effectsLevel = effectsLevel;
+
+        frames[next] = current;
+        next = (next + 1) % frames.size();
+        filled = std::min(filled + 1, frames.size());
+
+        bool writing = writer.valid() && writer.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+        if (writer.valid() && !writing && !writer.get()) failed++;
+
+        if (budgetMs <= 0 || (current.updateMs <= budgetMs && current.drawMs <= budgetMs)) return false;
+        auto now = std::chrono::steady_clock::now();
+        if (writing || (dumps > 0 && std::chrono::duration<float>(now - lastDumpTime).count() < cooldownSeconds)) {
+            skipped++;
+            return false;
+        }
+        lastDumpTime = now;
+        dump(world);
+        return true;
+    }
+
+private:
+    struct Frame {
+        float phaseMs[NUM_PHASES] = {};
+        float updateMs = 0, drawMs = 0, frameMs = 0;
+        uint32_t tick = 0;
+        int ticks = 0;
+        uint8_t input = 0;          // every input bit held during the frame's ticks
+        int asteroids = 0, smallAsteroids = 0, bullets = 0, renderCommands = 0;
+        int hits = 0, splits = 0, spawns = 0, shots = 0, deaths = 0;
+        int effectsLevel = 0;       // effects governor level, 0 is the lowest detail
+    };
+
+    std::vector<Frame> frames;      // ring, next is the oldest once full
+    size_t next = 0;
+    size_t filled = 0;
+    Frame current;
+    std::chrono::steady_clock::time_point lapStart;
+    std::chrono::steady_clock::time_point lastDumpTime;
+    std::future<bool> writer;       // the dump being written, if any
+
+    // Copies the window oldest first and captures the world, then hands
+    // both to the writer
+    void dump(const GameWorld& world) {
+        std::vector<Frame> window(filled);
+        size_t oldest = (next + frames.size() - filled) % frames.size();
+        for (size_t i = 0; i < filled; ++i) window[i] = frames[(oldest + i) % frames.size()];
+        std::vector<char> snapshot;
+        WorldSnapshot::capture(world, snapshot);
+
+        char name[32];
+        snprintf(name, sizeof(name), "spike-%u", world.tick);
+        std::string base = (directory.empty() ? std::string() : directory + "/") + name;
+        lastDump = base + ".snap";
+        dumps++;
+        writer = std::async(std::launch::async, [directory = directory, keep = maxDumps, base,
+            window = std::move(window), snapshot = std::move(snapshot)] {
+            bool written = write(directory, base, window, snapshot);
+            prune(directory, keep);
+            return written;
+        });
+    }
+
+    static bool write(const std::string& directory, const std::string& base, const std::vector<Frame>& window, const std::vector<char>& snapshot) {
+        if (!directory.empty()) ofDirectory::createDirectory(directory, false, true);
+
+        std::ofstream csv(base + ".csv");
+        csv << "frame,tick,ticks,input,step_ms,sounds_ms,telemetry_ms,draw_world_ms,draw_hud_ms,update_ms,draw_ms,frame_ms,"
+            "asteroids,small_asteroids,bullets,render_commands,hits,splits,spawns,shots,deaths,effects_level\n";
+        for (size_t i = 0; i < window.size(); ++i) {
+            const Frame& f = window[i];
+            csv << int(i) - int(window.size() - 1) << ',' << f.tick << ',' << f.ticks << ',' << int(f.input);
+            for (float ms : f.phaseMs) csv << ',' << ms;
+            csv << ',' << f.updateMs << ',' << f.drawMs << ',' << f.frameMs << ',' << f.asteroids << ',' << f.smallAsteroids
+                << ',' << f.bullets << ',' << f.renderCommands << ',' << f.hits << ',' << f.splits << ',' << f.spawns
+                << ',' << f.shots << ',' << f.deaths << ',' << f.effectsLevel << '\n';
+        }
+        if (!csv) return false;
+
+        std::ofstream snap(base + ".snap", std::ios::binary | std::ios::trunc);
+        snap.write(snapshot.data(), std::streamsize(snapshot.size()));
+        return bool(snap);
+    }
+
+    // Deletes the oldest spike-* pairs so at most keep are left
+    static void prune(const std::string& directory, int keep) {
+        namespace fs = std::filesystem;
+        std::error_code error;
+        std::vector<std::pair<fs::file_time_type, fs::path>> snaps;
+        for (const fs::directory_entry& entry : fs::directory_iterator(directory.empty() ? "." : directory, error)) {
+            const fs::path& path = entry.path();
+            if (path.extension() == ".snap" && path.filename().string().compare(0, 6, "spike-") == 0) {
+                snaps.emplace_back(entry.last_write_time(error), path);
+            }
+        }
+        if (int(snaps.size()) <= keep) return;
+        std::sort(snaps.begin(), snaps.end());
+        for (size_t i = 0; i + keep < snaps.size(); ++i) {
+            fs::path csv = snaps[i].second;
+            fs::remove(snaps[i].second, error);
+            fs::remove(csv.replace_extension(".csv"), error);
+        }
+    }
+};
@@ -0,0 +1,196 @@
+#pragma once
+
+#include "ofMain.h"
+#include <cstdint>
+#include <future>
+#include <vector>
+
+// Coarse, slowly changing 2D flow that steers the asteroids.
+//
+// The field is stored as keyframes on a grid of about cellSize pixels that
+// tiles the wrapping world. Each keyframe is the curl of a periodic value
+// noise potential, so the flow has no sources or sinks and asteroids drift
+// along it instead of bunching up. Sampling blends the two current
+// keyframes bilinearly in space and linearly in time; the pair is stored
+// interleaved per grid node, so a lookup reads four nodes and nothing else.
+//
+// While one pair of keyframes is in use, the one after them is computed on
+// a worker thread. At each keyframe boundary the world waits for it if it
+// is not done yet (counted in stalls) and swaps it in. Keyframes depend
+// only on the seed and their index, so when a key arrives never changes
+// the simulation.
+//
+class FlowField {
+public:
+    float cellSize = 150.0f;        // target grid spacing in pixels
+    int ticksPerKey = 120;          // ticks between keyframes
+    int cellsPerLattice = 4;        // grid cells per noise lattice cell, sets the swirl size
+    float keyStep = 0.3f;           // noise time advanced per keyframe
+
+    ~FlowField() {
+        if (pending.valid()) pending.wait();
+    }
+
+    // startTick > 0 picks the field up mid-round, as a restored snapshot needs
+    void start(uint64_t seed, const glm::vec2& worldSize, uint32_t startTick = 0) {
+        if (pending.valid()) pending.wait();
+
+        this->seed = seed;
+        cols = std::max(2, int(worldSize.x / cellSize + 0.5f));
+        rows = std::max(2, int(worldSize.y / cellSize + 0.5f));
+        cellsPerPixelX = cols / worldSize.x;
+        cellsPerPixelY = rows / worldSize.y;
+        latticeCols = std::max(2, cols / cellsPerLattice);
+        latticeRows = std::max(2, rows / cellsPerLattice);
+        tick = startTick;
+        blend = float(tick % ticksPerKey) / ticksPerKey;
+        stalls = 0;
+
+        key = int(tick / ticksPerKey);
+        std::vector<float> first;
+        generate(key, first);
+        generate(key + 1, newest);
+        interleave(first, newest, pair);
+        requestNext();
+    }
+
+    // One simulation tick; swaps in the next keyframe on a boundary
+    void advance() {
+        tick++;
+        if (tick % ticksPerKey == 0) {
+            if (pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready) stalls++;
+            pending.get();
+            pair.swap(nextPair);
+            key++;
+            requestNext();
+        }
+        blend = float(tick % ticksPerKey) / ticksPerKey;
+    }
+
+    // Flow at a world position, length up to about 1
+    glm::vec3 sample(const glm::vec3& pos) const {
+        // Positions stay inside the world, so truncation is floor and the
+        // only cell past the edge is the one on the far edge itself
+        float gx = pos.x * cellsPerPixelX;
+        float gy = pos.y * cellsPerPixelY;
+        int x0 = int(gx);
+        int y0 = int(gy);
+        float fx = gx - x0;
+        float fy = gy - y0;
+        if (x0 >= cols) x0 -= cols;
+        if (y0 >= rows) y0 -= rows;
+        int x1 = x0 + 1 == cols ? 0 : x0 + 1;
+        int y1 = y0 + 1 == rows ? 0 : y0 + 1;
+
+        // Four corners, each blended between the two keyframes
+        int corners[4] = { (y0 * cols + x0) * 4, (y0 * cols + x1) * 4, (y1 * cols + x0) * 4, (y1 * cols + x1) * 4 };
+        float weights[4] = { (1 - fx) * (1 - fy), fx * (1 - fy), (1 - fx) * fy, fx * fy };
+        float vx = 0, vy = 0;
+        for (int i = 0; i < 4; ++i) {
+            const float* node = &pair[corners[i]];
+            vx += weights[i] * (node[0] + (node[2] - node[0]) * blend);
+            vy += weights[i] * (node[1] + (node[3] - node[1]) * blend);
+        }
+        return glm::vec3(vx, vy, 0);
+    }
+
+    int stalls = 0;     // keyframe boundaries that had to wait for the worker
+
+private:
+    uint64_t seed = 0;
+    int cols = 2, rows = 2;
+    float cellsPerPixelX = 1, cellsPerPixelY = 1;
+    int latticeCols = 2, latticeRows = 2;
+    uint32_t tick = 0;
+    float blend = 0;
+    int key = 0;                        // index of the earlier keyframe in pair
+    std::vector<float> pair;            // keyframes key and key + 1, x/y/x/y per grid node
+    std::vector<float> nextPair;        // key + 1 and key + 2, filled by the worker
+    std::vector<float> newest;          // latest keyframe generated, x/y per grid node
+    std::future<void> pending;
+
+    static int wrap(int i, int n) {
+        i %= n;
+        return i < 0 ? i + n : i;
+    }
+
+    // The worker owns newest and nextPair until the next boundary
+    void requestNext() {
+        int nextKey = key + 2;
+        pending = std::async(std::launch::async, [this, nextKey] {
+            std::vector<float> fresh;
+            generate(nextKey, fresh);
+            interleave(newest, fresh, nextPair);
+            newest.swap(fresh);
+        });
+    }
+
+    static void interleave(const std::vector<float>& a, const std::vector<float>& b, std::vector<float>& out) {
+        out.resize(a.size() * 2);
+        for (size_t i = 0; i < a.size(); i += 2) {
+            out[i * 2] = a[i];
+            out[i * 2 + 1] = a[i + 1];
+            out[i * 2 + 2] = b[i];
+            out[i * 2 + 3] = b[i + 1];
+        }
+    }
+
+    // Lattice value in [-1, 1]
+    float lattice(int x, int y, int z) const {
+        uint64_t h = seed ^ (uint64_t(uint32_t(x)) * 0x9E3779B97F4A7C15ULL) ^ (uint64_t(uint32_t(y)) * 0xC2B2AE3D27D4EB4FULL)
+            ^ (uint64_t(uint32_t(z)) * 0x165667B19E3779F9ULL);
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 33;
+        return float(h >> 40) / float(1 << 23) - 1.0f;
+    }
+
+    // Value noise that repeats every latticeCols x latticeRows, so the field wraps with the world
+    float potential(float x, float y, float t) const {
+        int x0 = int(floor(x)), y0 = int(floor(y)), t0 = int(floor(t));
+        float fx = x - x0, fy = y - y0, ft = t - t0;
+        fx = fx * fx * (3 - 2 * fx);
+        fy = fy * fy * (3 - 2 * fy);
+        ft = ft * ft * (3 - 2 * ft);
+        int xa = wrap(x0, latticeCols), xb = wrap(x0 + 1, latticeCols);
+        int ya = wrap(y0, latticeRows), yb = wrap(y0 + 1, latticeRows);
+
+        float v[2];
+        for (int i = 0; i < 2; ++i) {
+            float top = ofLerp(lattice(xa, ya, t0 + i), lattice(xb, ya, t0 + i), fx);
+            float bottom = ofLerp(lattice(xa, yb, t0 + i), lattice(xb, yb, t0 + i), fx);
+            v[i] = ofLerp(top, bottom, fy);
+        }
+        return ofLerp(v[0], v[1], ft);
+    }
+
+    // Keyframe k: curl of the potential, scaled so the strongest flow is 1
+    void generate(int k, std::vector<float>& out) const {
+        std::vector<float> psi(cols * rows);
+        float t = k * keyStep;
+        for (int y = 0; y < rows; ++y) {
+            for (int x = 0; x < cols; ++x) {
+                psi[y * cols + x] = potential(float(x) * latticeCols / cols, float(y) * latticeRows / rows, t);
+            }
+        }
+
+        out.resize(cols * rows * 2);
+        float strongest = 0;
+        for (int y = 0; y < rows; ++y) {
+            int up = wrap(y - 1, rows), down = wrap(y + 1, rows);
+            for (int x = 0; x < cols; ++x) {
+                int left = wrap(x - 1, cols), right = wrap(x + 1, cols);
+                float vx = (psi[down * cols + x] - psi[up * cols + x]) * 0.5f;
+                float vy = -(psi[y * cols + right] - psi[y * cols + left]) * 0.5f;
+                out[(y * cols + x) * 2] = vx;
+                out[(y * cols + x) * 2 + 1] = vy;
+                strongest = std::max(strongest, vx * vx + vy * vy);
+            }
+        }
+
+        if (strongest > 0) {
+            float scale = 1.0f / sqrt(strongest);
+            for (float& v : out) v *= scale;
+        }
+    }
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdarg>
+#include <new>
+#include <vector>
+
+// Bump-pointer arena for data that only lives for one frame (draw scratch
+// buffers, formatted HUD text). ofApp::update resets it at the top of every
+// frame, so nothing allocated here may be kept past the next update.
+//
+// When the arena is full, allocations fall back to the global heap and are
+// counted, so the debug overlay can show if the capacity is too small.
+//
+class FrameArena {
+public:
+    FrameArena(size_t capacity = 256 * 1024) : buffer(capacity) {}
+
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+        size_t start = (used + alignment - 1) & ~(alignment - 1);
+        if (start + bytes > buffer.size()) {
+            fallbacks++;
+            return ::operator new(bytes);
+        }
+        used = start + bytes;
+        if (used > peak) peak = used;
+        return buffer.data() + start;
+    }
+
+    void deallocate(void* p, size_t bytes) {
+        unsigned char* ptr = static_cast<unsigned char*>(p);
+        if (!owns(ptr)) {
+            ::operator delete(p);
+            return;
+        }
+        // Only the most recent allocation can be given back
+        if (ptr + bytes == buffer.data() + used) {
+            used = ptr - buffer.data();
+        }
+    }
+
+    bool owns(const void* p) const {
+        const unsigned char* ptr = static_cast<const unsigned char*>(p);
+        return ptr >= buffer.data() && ptr < buffer.data() + buffer.size();
+    }
+
+    // printf into the arena; the text is valid until the next reset
+    const char* format(const char* fmt, ...) {
+        va_list args;
+        va_start(args, fmt);
+        va_list copy;
+        va_copy(copy, args);
+        int length = vsnprintf(nullptr, 0, fmt, copy);
+        va_end(copy);
+
+        char* text = static_cast<char*>(allocate(size_t(length) + 1, 1));
+        vsnprintf(text, size_t(length) + 1, fmt, args);
+        va_end(args);
+        return text;
+    }
+
+    // Start a new frame, keeping last frame's numbers for the debug overlay
+    void reset() {
+        lastFrameBytes = peak;
+        lastFrameFallbacks = fallbacks;
+        used = 0;
+        peak = 0;
+        fallbacks = 0;
+    }
+
+    size_t capacity() const { return buffer.size(); }
+    size_t bytesUsed() const { return used; }
+
+    size_t lastFrameBytes = 0;      // high-water mark of the previous frame
+    int lastFrameFallbacks = 0;     // heap fallbacks in the previous frame
+
+private:
+    std::vector<unsigned char> buffer;
+    size_t used = 0;
+    size_t peak = 0;
+    int fallbacks = 0;
+};
+
+inline FrameArena& frameArena() {
+    static FrameArena arena;
+    return arena;
+}
+
+// STL allocator that takes its memory from a FrameArena, e.g.
+// std::vector<glm::vec3, ArenaAllocator<glm::vec3>>
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    ArenaAllocator(FrameArena& arena = frameArena()) : arena(&arena) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, size_t n) {
+        arena->deallocate(p, n * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+
+    FrameArena* arena;
+};
+
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "ofMain.h"
+#include <vector>
+
+// Gameplay event recorded by the collision and gameplay code during a frame.
+// Score, audio, spawning and stats are applied afterwards from the queue.
+//
+struct GameEvent {
+    enum Type {
+        ASTEROID_HIT,       // a bullet destroyed an asteroid, size says which kind
+        ASTEROID_SPLIT,     // a large asteroid broke into count small ones
+        PLAYER_DEATH,       // the player crashed into an asteroid
+        SPAWN_REQUEST,      // top the asteroid field back up
+        SHOT                // the player fired a bullet
+    };
+
+    enum Size {
+        LARGE,
+        SMALL
+    };
+
+    Type type;
+    Size size;
+    glm::vec3 pos;
+    int count;
+};
+
+// Contiguous per-frame buffer of GameEvents, cleared at the start of each update
+class GameEventQueue {
+public:
+    void hit(GameEvent::Size size, const glm::vec3& pos) { push(GameEvent::ASTEROID_HIT, size, pos, 1); }
+    void split(const glm::vec3& pos, int pieces) { push(GameEvent::ASTEROID_SPLIT, GameEvent::LARGE, pos, pieces); }
+    void playerDeath(const glm::vec3& pos) { push(GameEvent::PLAYER_DEATH, GameEvent::SMALL, pos, 1); }
+    void spawnRequest() { push(GameEvent::SPAWN_REQUEST, GameEvent::LARGE, glm::vec3(0, 0, 0), 1); }
+    void shot(const glm::vec3& pos) { push(GameEvent::SHOT, GameEvent::SMALL, pos, 1); }
+
+    void clear() { events.clear(); }
+    bool empty() const { return events.empty(); }
+    size_t size() const { return events.size(); }
+
+    std::vector<GameEvent>::const_iterator begin() const { return events.begin(); }
+    std::vector<GameEvent>::const_iterator end() const { return events.end(); }
+
+    // Number of events of one type (and size, for hits) this frame
+    int count(GameEvent::Type type) const {
+        int n = 0;
+        for (const GameEvent& e : events) {
+            if (e.type == type) n++;
+        }
+        return n;
+    }
+
+    int count(GameEvent::Type type, GameEvent::Size size) const {
+        int n = 0;
+        for (const GameEvent& e : events) {
+            if (e.type == type && e.size == size) n++;
+        }
+        return n;
+    }
+
+private:
+    std::vector<GameEvent> events;
+
+    void push(GameEvent::Type type, GameEvent::Size size, const glm::vec3& pos, int count) {
+        GameEvent e;
+        e.type = type;
+        e.size = size;
+        e.pos = pos;
+        e.count = count;
+        events.push_back(e);
+    }
+};
@@ -0,0 +1,632 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Player.h"
+#include "BulletStore.h"
+#include "Asteroid.h"
+#include "CollisionSystem.h"
+#include "FastRandom.h"
+#include "SpawnSampler.h"
+#include "TimerWheel.h"
+#include "GameEvents.h"
+#include "RenderCuller.h"
+#include "GravityField.h"
+#include "FlowField.h"
+#include "MemoryTracker.h"
+#include <memory>
+
+// The gameplay simulation, separate from windowing, sound and menus.
+//
+// A world only depends on its seed and the input bitmask of each tick.
+// Randomness comes from its own FastRandom and time from its TimerWheel,
+// so a recorded session replays exactly, in a window or headless.
+//
+class GameWorld {
+public:
+    // Player input for one tick
+    enum InputBits {
+        INPUT_LEFT = 1 << 0,
+        INPUT_RIGHT = 1 << 1,
+        INPUT_FORWARD = 1 << 2,
+        INPUT_BACKWARD = 1 << 3,
+        INPUT_SHOOT = 1 << 4,
+        INPUT_QUIT = 1 << 5
+    };
+
+    // Where the asteroids' wander comes from
+    enum Steering {
+        STEER_RANDOM_WALK,      // fresh random nudge every tick (replays before version 4)
+        STEER_FLOW_FIELD        // drift along the shared flow field
+    };
+
+    GameWorld() {}
+    GameWorld(const GameWorld&) = delete;             // timers point back at this world
+    GameWorld& operator=(const GameWorld&) = delete;
+
+    // Clear & reset all values for a new round in a width x height world;
+    // an endless round grows the world to fit its population
+    void start(uint64_t seed, float width, float height) {
+        MemoryScope memoryScope(MemoryTag::WORLD);
+        this->seed = seed;
+        worldSize = isEndless() ? stressWorldSize(stressPopulation, width, height) : glm::vec2(width, height);
+        lodSettings.viewSize = glm::vec2(width, height);
+        rng.setSeed(seed);
+        applyReferencePath();
+        GameRandomScope randomScope(rng);
+        if (steering == STEER_FLOW_FIELD) flowField.start(seed, worldSize);
+
+        timers.clear();
+        events.clear();
+        player.reset(new Player(timers, glm::vec3(width / 2, height / 2, 0)));
+        extraShips.clear();
+        for (int k = 1; k < std::min(shipCount, maxShips); ++k) {
+            ShipSlot slot;
+            slot.ship.reset(new Player(timers, glm::vec3(width / 2, height / 2, 0) + shipOffsets()[k]));
+            slot.ship->color = shipColors()[k];
+            extraShips.push_back(std::move(slot));
+        }
+        nextEntityId = 1;
+        resetBullets();
+        asteroids.clear();
+        smallAsteroids.clear();
+        score = 0;
+        playerDeaths = 0;
+        asteroidsDestroyed = 0;
+        tick = 0;
+        timer = isEndless() ? 0 : roundLength;
+        timesUp = false;
+        canFire = true;
+
+        // Round ends when the timer runs out, endless rounds only when the player quits
+        roundTimer = TimerWheel::Handle();
+        fireTimer = TimerWheel::Handle();
+        despawnTimers.clear();
+        if (!isEndless()) scheduleRoundEnd(TimerWheel::secondsToTicks(roundLength));
+
+        // Spawn Asteroids
+        findSpawnPositions(targetAsteroids());
+        for (const glm::vec3& spawnPos : spawnPositions) {
+            int randomSides = int(rng.next(10, 20));
+            asteroids.push_back(Asteroid(spawnPos, randomSides));
+        }
+        assignIds();
+
+        // Gravity wells, away from the player like the asteroids
+        wells.clear();
+        if (gravity) {
+            findSpawnPositions(gravityWells);
+            for (const glm::vec3& wellPos : spawnPositions) {
+                wells.push_back({ wellPos, wellMass });
+            }
+        }
+    }
+
+    // Advance the simulation by one tick
+    void step(uint8_t input) {
+        step(&input, 1);
+    }
+
+    // One tick with an input per ship; ships past count get no input
+    void step(const uint8_t* inputs, int count) {
+        MemoryScope memoryScope(MemoryTag::WORLD);
+        uint8_t input = inputs[0];
+        GameRandomScope randomScope(rng);
+        tick++;
+
+        // One gameplay tick; fires whichever timers are due
+        events.clear();
+        timers.advance();
+
+        // Count Down Timer, the round end itself is scheduled in start()
+        // Endless rounds count up instead
+        if (isEndless()) timer = float(tick) / TimerWheel::ticksPerSecond;
+        else timer = float(timers.ticksRemaining(roundTimer)) / TimerWheel::ticksPerSecond;
+
+        // Player can exit the round early
+        if (input & INPUT_QUIT) {
+            timesUp = true;
+            return;
+        }
+
+        // Handle player movement
+        if (input & INPUT_LEFT) { player->rotate(-5.0f); }
+        if (input & INPUT_RIGHT) { player->rotate(5.0f); }
+        if (input & INPUT_FORWARD) { player->thrust(0.1f); }
+        if (input & INPUT_BACKWARD) { player->thrust(-0.1f); }
+
+        player->update(worldSize);
+        bullets.update(worldSize, tick);
+
+        // Handle shooting, the cooldown timer re-arms the gun
+        if ((input & INPUT_SHOOT) && canFire && !player->invulnerable && !player->isExploding) {
+            bullets.emit(player->pos, player->rot, 8.0f, player->velocity, tick);
+            canFire = false;
+            scheduleFireCooldown(TimerWheel::secondsToTicks(fireRate));
+            events.shot(player->pos);
+        }
+
+        // Other ships in a multiplayer arena, same controls
+        for (size_t k = 0; k < extraShips.size(); ++k) {
+            uint8_t shipInput = int(k) + 1 < count ? inputs[k + 1] : 0;
+            stepExtraShip(k, shipInput);
+        }
+
+        // Random walk steering for every asteroid is drawn in one batch;
+        // the flow field is sampled per asteroid as it updates instead
+        const float* steer = nullptr;
+        if (steering == STEER_FLOW_FIELD) {
+            flowField.advance();
+        }
+        else {
+            size_t numAsteroids = asteroids.size() + smallAsteroids.size();
+            steeringBuffer.resize(numAsteroids * 2);
+            rng.fill(steeringBuffer.data(), steeringBuffer.size(), -0.1f, 0.1f);
+            steer = steeringBuffer.data();
+        }
+
+        // Gravity mode pulls the asteroids towards each other and the wells
+        if (gravity) applyGravity();
+
+        // Update large asteroids, far ones less often (simulation LOD)
+        lodStats = SimLodStats();
+        collisionSystem.lodSkippedPairs = 0;
+        lodView = cameraView(lodSettings.viewSize.x, lodSettings.viewSize.y);
+        for (size_t i = 0; i < asteroids.size(); ++i) {
+            updateWithLod(asteroids[i], i, steer ? steer + i * 2 : nullptr);
+        }
+
+        // Update all small asteroids
+        for (size_t i = 0; i < smallAsteroids.size(); ++i) {
+            updateWithLod(smallAsteroids[i], i, steer ? steer + (asteroids.size() + i) * 2 : nullptr);
+        }
+
+        // Collisions only record events; their effects are applied in applyEvents()
+        if (isEndless()) {
+            // Crowded stress worlds go through the grid broadphase
+            collisionSystem.buildGrid(asteroids, smallAsteroids, worldSize);
+            collisionSystem.BulletAsteroidCollisionGrid(bullets, asteroids, smallAsteroids, events);
+            collisionSystem.PlayerAsteroidCollisionGrid(*player, asteroids, smallAsteroids, events);
+            for (ShipSlot& slot : extraShips) {
+                collisionSystem.PlayerAsteroidCollisionGrid(*slot.ship, asteroids, smallAsteroids, events);
+            }
+            collisionSystem.AsteroidCollisionGrid(asteroids, smallAsteroids);
+        }
+        else {
+            // Check for bullet collisions with large asteroids, then small ones
+            collisionSystem.BulletAsteroidCollision(bullets, asteroids, events);
+            collisionSystem.BulletAsteroidCollision(bullets, smallAsteroids, events);
+
+            // Check player collision with large asteroids, then small ones, and the other ships'
+            for (int k = 0; k < numShips(); ++k) {
+                collisionSystem.PlayerAsteroidCollision(ship(k), asteroids, events);
+                collisionSystem.PlayerAsteroidCollision(ship(k), smallAsteroids, events);
+            }
+
+            // Check collision between large asteroids
+            collisionSystem.LargeAsteroidCollision(asteroids);
+
+            // Check collision between large and small asteroids as well
+            collisionSystem.LargeSmallAsteroidCollision(asteroids, smallAsteroids);
+        }
+
+        // Check the game to see if at least targetAsteroids() asteroids are in play
+        // An endless round tops its population up once a second whatever else is flying
+        if (int(asteroids.size()) < targetAsteroids()) {
+            if (isEndless() ? tick % TimerWheel::ticksPerSecond == 0 : smallAsteroids.size() <= 0) {
+                events.spawnRequest();
+            }
+        }
+
+        lodStats.skippedPairs = collisionSystem.lodSkippedPairs;
+        applyEvents();
+        assignIds();
+    }
+
+    // Draw what touches view (world coordinates), with ghost copies of
+    // anything straddling a world edge; everything goes through the render
+    // queue and reaches backend as sorted, merged batches
+    void draw(const ofRectangle& view, RenderBackend& backend) {
+        MemoryScope memoryScope(MemoryTag::RENDER);
+        culler.begin(view, worldSize);
+
+        glm::vec3 center;
+        float radius;
+        for (int k = 0; k < numShips(); ++k) {
+            ship(k).getDrawBounds(center, radius);
+            culler.add(RenderCuller::PLAYER, k, center, radius);
+        }
+        for (size_t i = 0; i < asteroids.size(); ++i) {
+            if (asteroids[i].getDrawBounds(center, radius)) culler.add(RenderCuller::ASTEROID, int(i), center, radius);
+        }
+        for (size_t i = 0; i < smallAsteroids.size(); ++i) {
+            if (smallAsteroids[i].getDrawBounds(center, radius)) culler.add(RenderCuller::SMALL_ASTEROID, int(i), center, radius);
+        }
+
+        // draw() covers the outline and the explosion particles
+        renderQueue.begin();
+        drawWells(view);
+        for (const RenderCuller::Item& item : culler.items) {
+            renderQueue.setOffset(item.offset);
+            if (item.kind == RenderCuller::PLAYER) ship(item.index).draw(renderQueue);
+            else if (item.kind == RenderCuller::ASTEROID) asteroids[item.index].draw(renderQueue);
+            else smallAsteroids[item.index].draw(renderQueue);
+        }
+
+        // Bullets leave the world instead of wrapping and are drawn as they are
+        renderQueue.setOffset(glm::vec3(0, 0, 0));
+        bullets.draw(renderQueue);
+
+        renderQueue.flush(backend);
+    }
+
+    // Window-sized view centred on the player and kept inside the world;
+    // fixed at the origin when the world fits the window
+    ofRectangle cameraView(float width, float height) const {
+        float x = ofClamp(player->pos.x - width / 2, 0, std::max(0.0f, worldSize.x - width));
+        float y = ofClamp(player->pos.y - height / 2, 0, std::max(0.0f, worldSize.y - height));
+        return ofRectangle(x, y, width, height);
+    }
+
+    bool isStarted() const { return player != nullptr; }
+    int numShips() const { return 1 + int(extraShips.size()); }
+    Player& ship(int i) { return i == 0 ? *player : *extraShips[i - 1].ship; }
+    const Player& ship(int i) const { return i == 0 ? *player : *extraShips[i - 1].ship; }
+    bool isEndless() const { return stressPopulation > 0; }
+    int targetAsteroids() const { return isEndless() ? stressPopulation : minAsteroids; }
+
+    // World for an endless round: big enough to give each large asteroid
+    // about areaPerAsteroid of room, and never smaller than the screen
+    static glm::vec2 stressWorldSize(int population, float screenWidth, float screenHeight) {
+        const float areaPerAsteroid = 300.0f * 300.0f;
+        float side = sqrt(float(population) * areaPerAsteroid);
+        return glm::vec2(std::max(side, screenWidth), std::max(side, screenHeight));
+    }
+
+    uint64_t seed = 0;
+    uint32_t tick = 0;
+    uint32_t nextEntityId = 1;          // asteroids get stable ids for network snapshots
+    glm::vec2 worldSize;
+
+    // Run the plain reference code instead of the optimized paths: scalar
+    // random draws one value at a time, brute-force collision in place of
+    // the grid, every asteroid at full rate instead of LOD bands, the exact
+    // O(n^2) gravity sum and one-bullet-at-a-time bullet loops. The
+    // differential runner steps one of each and compares their hashes; LOD
+    // and Barnes-Hut are approximations, so replays where they kick in are
+    // expected to part ways and the report says when.
+    bool referencePath = false;
+
+    // Declared before the entities, which may hold timers until they are destroyed
+    FastRandom rng;
+    TimerWheel timers;
+    TimerWheel::Handle roundTimer;
+    TimerWheel::Handle fireTimer;
+    std::vector<TimerWheel::Handle> despawnTimers;     // explosion sweeps still to run
+
+    std::unique_ptr<Player> player;
+
+    // Ships after the first in a multiplayer arena, each with its own gun cooldown
+    struct ShipSlot {
+        std::unique_ptr<Player> ship;
+        bool canFire = true;
+        TimerWheel::Handle fireTimer;
+    };
+    static const int maxShips = 4;
+    std::vector<ShipSlot> extraShips;
+
+    // Where ships 1 - 3 start, around the first ship, and their colours
+    static const glm::vec3* shipOffsets() {
+        static const glm::vec3 offsets[maxShips] = {
+            glm::vec3(0, 0, 0), glm::vec3(-200, 0, 0), glm::vec3(200, 0, 0), glm::vec3(0, 150, 0)
+        };
+        return offsets;
+    }
+
+    static const ofColor* shipColors() {
+        static const ofColor colors[maxShips] = {
+            ofColor(0, 255, 0), ofColor(0, 200, 255), ofColor(255, 200, 0), ofColor(255, 80, 200)
+        };
+        return colors;
+    }
+
+    BulletStore bullets;
+    std::vector<Asteroid> asteroids;
+    std::vector<SmallAsteroid> smallAsteroids;
+
+    int score = 0;
+    int playerDeaths = 0;
+    int asteroidsDestroyed = 0;
+
+    float timer = 120.0f;
+    bool timesUp = false;
+
+    bool canFire = true;
+
+    // Balance settings, set before start()
+    float roundLength = 120.0f;         // seconds per round
+    float fireRate = 0.2f;              // seconds between shots
+    float bulletLifetime = 4.0f;        // seconds a bullet flies before it expires, if it has not left the world
+    int minAsteroids = 7;               // large asteroids kept in play
+    int baseSides = 10;                 // new asteroids get baseSides + asteroidsDestroyed / destroyedPerSide sides
+    int destroyedPerSide = 10;
+    float minDistanceFromPlayer = 100.0f;
+    int shipCount = 1;                  // ships in the arena, 2 - 4 for multiplayer
+    int stressPopulation = 0;           // > 0 for an endless stress round with this many large asteroids
+    SimLodSettings lodSettings;         // simulation LOD radii and update intervals
+    Steering steering = STEER_FLOW_FIELD;
+    float flowStrength = 0.05f;         // flow field steering per tick
+    bool gravity = false;               // asteroids and wells attract each other
+    int gravityWells = 3;               // wells placed at the start of a gravity round
+    float wellMass = 500.0f;            // a large asteroid weighs 4, a small one 1
+    GravityField gravityField;          // opening angle and strength are set here
+
+    GameEventQueue events;      // this tick's events, read by the app for sound
+    RenderCuller culler;        // last frame's draw list and culling stats
+    RenderQueue renderQueue;    // last frame's batching stats
+    SimLodStats lodStats;       // last tick's simulation LOD work
+    CollisionSystem collisionSystem;
+    std::vector<GravityWell> wells;
+    FlowField flowField;
+
+private:
+    friend class WorldSnapshot;     // restores the state and re-arms the timers below
+
+    std::vector<float> steeringBuffer;  // per-tick random steering, x/y per asteroid
+    ofRectangle lodView;                // camera view this tick, kept at full simulation rate
+    SpawnSampler spawnSampler;
+    std::vector<glm::vec3> spawnPositions;
+    std::vector<glm::vec3> gravityAccelerations;
+
+    // Step an asteroid if its LOD band is due this tick, catching up every tick it missed;
+    // walk is the asteroid's random walk x/y, or null to follow the flow field
+    template <typename T>
+    void updateWithLod(T& asteroid, size_t index, const float* walk) {
+        SimLod& lod = asteroid.lod;
+        lod.behind++;
+        if (lod.behind < lod.wait && !asteroid.isExploding()) {
+            lodStats.skippedUpdates++;
+            return;
+        }
+
+        // Random walk steering over the missed ticks grows with the square
+        // root of their number, the flow's steady pull with the number itself
+        int ticks = lod.behind;
+        glm::vec3 steer;
+        if (walk) steer = glm::vec3(walk[0], walk[1], 0);
+        else steer = flowField.sample(asteroid.getPosition()) * flowStrength;
+        if (ticks > 1) {
+            steer *= walk ? sqrt(float(ticks)) : float(ticks);
+            lodStats.catchUpUpdates++;
+        }
+        else {
+            lodStats.fullUpdates++;
+        }
+        asteroid.update(steer, worldSize, ticks);
+        asteroid.updateExplosion();
+        lod.behind = 0;
+
+        // Band for the next update; entering a new band starts at a staggered
+        // wait so asteroids that change band together do not update together
+        // The reference path keeps every asteroid at full rate
+        glm::vec3 center = asteroid.getPosition();
+        bool inView = center.x + T::maxRadius >= lodView.getLeft() && center.x - T::maxRadius <= lodView.getRight() &&
+            center.y + T::maxRadius >= lodView.getTop() && center.y - T::maxRadius <= lodView.getBottom();
+        int interval = referencePath || asteroid.isExploding() ? 1 : lodSettings.intervalFor(wrappedDistance(center, player->pos, worldSize), inView);
+        lod.wait = interval == lod.interval ? interval : 1 + int(index % interval);
+        lod.interval = interval;
+    }
+
+    // Switches the generator, bullets and collision passes to match referencePath
+    void applyReferencePath() {
+        rng.setVectorized(!referencePath);
+        bullets.referenceLoops = referencePath;
+        collisionSystem.bruteForce = referencePath;
+    }
+
+    // Movement and shooting for ship k + 1
+    void stepExtraShip(size_t k, uint8_t input) {
+        ShipSlot& slot = extraShips[k];
+        Player& ship = *slot.ship;
+        if (input & INPUT_LEFT) { ship.rotate(-5.0f); }
+        if (input & INPUT_RIGHT) { ship.rotate(5.0f); }
+        if (input & INPUT_FORWARD) { ship.thrust(0.1f); }
+        if (input & INPUT_BACKWARD) { ship.thrust(-0.1f); }
+        ship.update(worldSize);
+
+        if ((input & INPUT_SHOOT) && slot.canFire && !ship.invulnerable && !ship.isExploding) {
+            bullets.emit(ship.pos, ship.rot, 8.0f, ship.velocity, tick);
+            slot.canFire = false;
+            scheduleShipFireCooldown(k, TimerWheel::secondsToTicks(fireRate));
+            events.shot(ship.pos);
+        }
+    }
+
+    // Ids for asteroids spawned or split off since the last call
+    void assignIds() {
+        for (Asteroid& asteroid : asteroids) {
+            if (asteroid.id == 0) asteroid.id = nextEntityId++;
+        }
+        for (SmallAsteroid& smallAsteroid : smallAsteroids) {
+            if (smallAsteroid.id == 0) smallAsteroid.id = nextEntityId++;
+        }
+    }
+
+    // One Barnes-Hut pass over every live asteroid and well; asteroids the
+    // LOD pass skips keep the pull until their next update
+    void applyGravity() {
+        gravityField.clear();
+        for (const Asteroid& asteroid : asteroids) {
+            if (!asteroid.isExploding()) gravityField.addBody(asteroid.getPosition(), asteroid.getGravityMass());
+        }
+        for (const SmallAsteroid& smallAsteroid : smallAsteroids) {
+            if (!smallAsteroid.isExploding()) gravityField.addBody(smallAsteroid.getPosition(), smallAsteroid.getGravityMass());
+        }
+        for (const GravityWell& well : wells) {
+            gravityField.addBody(well.pos, well.mass);
+        }
+        if (referencePath) {
+            gravityField.computeAccelerationsExact(gravityAccelerations);
+        }
+        else {
+            gravityField.build();
+            gravityField.computeAccelerations(gravityAccelerations);
+        }
+
+        // Bodies were added in this order; the wells themselves never move
+        const glm::vec3* acc = gravityAccelerations.data();
+        for (Asteroid& asteroid : asteroids) {
+            if (!asteroid.isExploding()) asteroid.applyForce(*acc++);
+        }
+        for (SmallAsteroid& smallAsteroid : smallAsteroids) {
+            if (!smallAsteroid.isExploding()) smallAsteroid.applyForce(*acc++);
+        }
+    }
+
+    // Wells are drawn as dim rings under the asteroids
+    void drawWells(const ofRectangle& view) {
+        const int segments = 24;
+        const float radius = 12.0f;
+        renderQueue.setOffset(glm::vec3(0, 0, 0));
+        for (const GravityWell& well : wells) {
+            if (well.pos.x + radius < view.getLeft() || well.pos.x - radius > view.getRight() ||
+                well.pos.y + radius < view.getTop() || well.pos.y - radius > view.getBottom()) continue;
+
+            glm::vec3* v = renderQueue.lines(RenderQueue::LAYER_ASTEROIDS, ofColor(120), segments * 2);
+            for (int i = 0; i < segments; ++i) {
+                float a0 = TWO_PI * i / segments, a1 = TWO_PI * (i + 1) / segments;
+                *v++ = well.pos + glm::vec3(cos(a0) * radius, sin(a0) * radius, 0);
+                *v++ = well.pos + glm::vec3(cos(a1) * radius, sin(a1) * radius, 0);
+            }
+        }
+    }
+
+    // Apply this tick's gameplay events in batched passes
+    void applyEvents() {
+        int largeHits = 0;
+        int smallHits = 0;
+        int spawnRequests = 0;
+
+        // Score and stats, every event counts
+        for (const GameEvent& e : events) {
+            switch (e.type) {
+            case GameEvent::ASTEROID_HIT:
+                if (e.size == GameEvent::LARGE) {
+                    score += 100;
+                    largeHits++;
+                }
+                else {
+                    score += 50;
+                    smallHits++;
+                }
+                asteroidsDestroyed++;
+                break;
+            case GameEvent::PLAYER_DEATH:
+                score = std::max(0, score - 75);
+                playerDeaths++;
+                break;
+            case GameEvent::SPAWN_REQUEST:
+                spawnRequests++;
+                break;
+            default:
+                break;
+            }
+        }
+
+        // Split pieces, in the order the hits happened; only large asteroids split
+        for (const GameEvent& e : events) {
+            if (e.type == GameEvent::ASTEROID_SPLIT) Asteroid::addPieces(e.pos, smallAsteroids);
+        }
+
+        // Despawns and spawning
+        if (largeHits > 0) scheduleDespawn(Asteroid::maxExplosionLifespan);
+        if (smallHits > 0) scheduleDespawn(SmallAsteroid::maxExplosionLifespan);
+        if (spawnRequests > 0) spawnAsteroids();
+    }
+
+    // Asteroids Spawner to populate game while playing
+    void spawnAsteroids() {
+        // At least targetAsteroids() asteroids must be in the game at any time
+        int numNewAsteroids = targetAsteroids() - int(asteroids.size());
+        if (numNewAsteroids <= 0) {
+            return;
+        }
+
+        // New asteroids added based on the number destroyed
+        // If the world is too crowded, the rest are added on a later tick
+        findSpawnPositions(numNewAsteroids);
+        int sizeFactor = baseSides + (asteroidsDestroyed / destroyedPerSide);
+        for (const glm::vec3& spawnPos : spawnPositions) {
+            asteroids.push_back(Asteroid(spawnPos, sizeFactor));
+        }
+    }
+
+    // Fills spawnPositions with up to count points away from the player and clear of all live asteroids
+    int findSpawnPositions(int count) {
+        float radius = Asteroid::maxRadius;
+        spawnSampler.reset(worldSize.x, worldSize.y, radius * 2);
+        spawnSampler.addExclusion(player->pos, minDistanceFromPlayer);
+        for (const ShipSlot& slot : extraShips) {
+            spawnSampler.addExclusion(slot.ship->pos, minDistanceFromPlayer);
+        }
+
+        for (const Asteroid& asteroid : asteroids) {
+            if (!asteroid.isExploding()) spawnSampler.addObstacle(asteroid.getPosition(), asteroid.getRadius());
+        }
+        for (const SmallAsteroid& smallAsteroid : smallAsteroids) {
+            if (!smallAsteroid.isExploding()) spawnSampler.addObstacle(smallAsteroid.getPosition(), smallAsteroid.getRadius());
+        }
+
+        spawnPositions.clear();
+        return spawnSampler.sample(count, radius, spawnPositions);
+    }
+
+    // Sweep out exploded asteroids once their particles can have faded
+    void scheduleDespawn(float explosionLifespan) {
+        scheduleSweep(TimerWheel::secondsToTicks(explosionLifespan) + 2);
+    }
+
+    // Every world timer is armed through these, so a snapshot restore can re-arm them
+    void scheduleRoundEnd(uint32_t ticks) {
+        roundTimer = timers.schedule(ticks, [this] {
+            timer = 0;
+            timesUp = true;
+        });
+    }
+
+    // Room for the most bullets that can be in flight: every ship firing as
+    // soon as its cooldown allows for a whole bullet lifetime
+    void resetBullets() {
+        uint32_t lifetime = std::max<uint32_t>(1, TimerWheel::secondsToTicks(bulletLifetime));
+        uint32_t cooldown = std::max<uint32_t>(1, TimerWheel::secondsToTicks(fireRate));
+        bullets.reset(size_t(numShips()) * (lifetime / cooldown + 1), lifetime);
+    }
+
+    void scheduleFireCooldown(uint32_t ticks) {
+        fireTimer = timers.schedule(ticks, [this] { canFire = true; });
+    }
+
+    void scheduleShipFireCooldown(size_t k, uint32_t ticks) {
+        extraShips[k].fireTimer = timers.schedule(ticks, [this, k] { extraShips[k].canFire = true; });
+    }
+
+    void scheduleSweep(uint32_t ticks) {
+        despawnTimers.erase(std::remove_if(despawnTimers.begin(), despawnTimers.end(),
+            [this](const TimerWheel::Handle& h) { return !timers.isPending(h); }), despawnTimers.end());
+        despawnTimers.push_back(timers.schedule(ticks, [this] { removeFinishedExplosions(); }));
+    }
+
+    void removeFinishedExplosions() {
+        // Remove asteroids of both sizes after explosions have finished
+        removeFinishedExplosions(asteroids);
+        removeFinishedExplosions(smallAsteroids);
+    }
+
+    template <typename Traits>
+    static void removeFinishedExplosions(std::vector<BasicAsteroid<Traits>>& list) {
+        list.erase(
+            std::remove_if(list.begin(), list.end(),
+                [](const BasicAsteroid<Traits>& a) { return a.isExplosionFinished(); }),
+            list.end()
+        );
+    }
+};
@@ -0,0 +1,264 @@
+#pragma once
+
+#include "ofMain.h"
+#include "JobPool.h"
+#include <vector>
+#include <algorithm>
+
+// Fixed point mass that pulls on the asteroids but never moves
+struct GravityWell {
+    glm::vec3 pos;
+    float mass;
+};
+
+// Barnes-Hut gravity between many bodies.
+//
+// Every tick the bodies are put into a quadtree whose nodes hold the total
+// mass and centre of mass beneath them. A body's pull is then summed by
+// walking the tree and treating any node that looks small enough from the
+// body (node size / distance < theta) as a single point mass, so the whole
+// pass is O(n log n) instead of O(n^2). theta = 0 is the exact sum; larger
+// values are faster and rougher.
+//
+// The tree below the root's four quadrants is built in parallel, one task
+// per quadrant, and the force pass is split into chunks of bodies. Each task
+// inserts its bodies in their original order and writes only its own nodes
+// and results, so the outcome is the same whatever thread runs what.
+// Distances do not wrap around the world edges.
+//
+class GravityField {
+public:
+    float theta = 0.6f;             // opening angle
+    float strength = 10.0f;         // gravitational constant
+    float softening = 20.0f;        // keeps close passes from slingshotting
+
+    void clear() {
+        bodies.clear();
+    }
+
+    void addBody(const glm::vec3& pos, float mass) {
+        bodies.push_back({ pos.x, pos.y, mass });
+    }
+
+    // Builds the tree from the bodies added since clear()
+    void build() {
+        nodes.clear();
+        if (bodies.empty()) return;
+
+        // Square around every body
+        float minX = bodies[0].x, maxX = minX, minY = bodies[0].y, maxY = minY;
+        for (const Body& b : bodies) {
+            minX = std::min(minX, b.x);
+            maxX = std::max(maxX, b.x);
+            minY = std::min(minY, b.y);
+            maxY = std::max(maxY, b.y);
+        }
+        float size = std::max(std::max(maxX - minX, maxY - minY), 1.0f) * 1.0001f;
+
+        Node root;
+        root.x = minX;
+        root.y = minY;
+        root.size = size;
+        root.leaf = false;
+
+        // Split the bodies between the root's quadrants
+        float half = size / 2;
+        for (std::vector<int>& q : quadrantBodies) q.clear();
+        for (int i = 0; i < int(bodies.size()); ++i) {
+            quadrantBodies[quadrantOf(root, bodies[i])].push_back(i);
+        }
+
+        // Build each quadrant's subtree on its own
+        sharedJobPool().run(4, [&](int q) {
+            std::vector<Node>& subtree = quadrantNodes[q];
+            subtree.clear();
+            if (quadrantBodies[q].empty()) return;
+
+            Node quadrant;
+            quadrant.x = root.x + (q & 1 ? half : 0);
+            quadrant.y = root.y + (q & 2 ? half : 0);
+            quadrant.size = half;
+            subtree.push_back(quadrant);
+            for (int body : quadrantBodies[q]) {
+                insert(subtree, body);
+            }
+            for (Node& node : subtree) {
+                if (node.mass > 0) {
+                    node.comX /= node.mass;
+                    node.comY /= node.mass;
+                }
+            }
+        });
+
+        // Stitch the subtrees under the root
+        nodes.push_back(root);
+        for (int q = 0; q < 4; ++q) {
+            std::vector<Node>& subtree = quadrantNodes[q];
+            if (subtree.empty()) continue;
+
+            int offset = int(nodes.size());
+            nodes[0].children[q] = offset;
+            nodes[0].mass += subtree[0].mass;
+            nodes[0].comX += subtree[0].comX * subtree[0].mass;
+            nodes[0].comY += subtree[0].comY * subtree[0].mass;
+            for (Node node : subtree) {
+                for (int& child : node.children) {
+                    if (child >= 0) child += offset;
+                }
+                nodes.push_back(node);
+            }
+        }
+        if (nodes[0].mass > 0) {
+            nodes[0].comX /= nodes[0].mass;
+            nodes[0].comY /= nodes[0].mass;
+        }
+    }
+
+    // Acceleration on every body, in the order they were added
+    void computeAccelerations(std::vector<glm::vec3>& out) {
+        out.assign(bodies.size(), glm::vec3(0, 0, 0));
+        if (nodes.empty()) return;
+
+        const int chunkSize = 256;
+        int chunks = int((bodies.size() + chunkSize - 1) / chunkSize);
+        sharedJobPool().run(chunks, [&](int chunk) {
+            std::vector<int> stack;
+            int end = std::min(int(bodies.size()), (chunk + 1) * chunkSize);
+            for (int i = chunk * chunkSize; i < end; ++i) {
+                out[i] = accelerationOn(i, stack);
+            }
+        });
+    }
+
+    // The exact pairwise sum, one body at a time in the order they were
+    // added; the reference the tree is checked against (--diff)
+    void computeAccelerationsExact(std::vector<glm::vec3>& out) const {
+        out.assign(bodies.size(), glm::vec3(0, 0, 0));
+        float soft2 = softening * softening;
+        for (size_t i = 0; i < bodies.size(); ++i) {
+            float ax = 0, ay = 0;
+            for (size_t j = 0; j < bodies.size(); ++j) {
+                if (j == i || bodies[j].mass <= 0) continue;
+                float dx = bodies[j].x - bodies[i].x;
+                float dy = bodies[j].y - bodies[i].y;
+                float dist2 = dx * dx + dy * dy + soft2;
+                float inv = strength * bodies[j].mass / (dist2 * sqrt(dist2));
+                ax += dx * inv;
+                ay += dy * inv;
+            }
+            out[i] = glm::vec3(ax, ay, 0);
+        }
+    }
+
+    size_t nodeCount() const { return nodes.size(); }
+
+private:
+    struct Body {
+        float x, y, mass;
+    };
+
+    struct Node {
+        float x = 0, y = 0, size = 0;       // square covered
+        float mass = 0;
+        float comX = 0, comY = 0;           // centre of mass (mass-weighted sum while building)
+        int children[4] = { -1, -1, -1, -1 };
+        int body = -1;                      // the one body in a leaf, -1 when empty or split
+        bool leaf = true;
+    };
+
+    static const int maxDepth = 24;
+
+    std::vector<Body> bodies;
+    std::vector<Node> nodes;
+    std::vector<int> quadrantBodies[4];
+    std::vector<Node> quadrantNodes[4];
+
+    static int quadrantOf(const Node& node, const Body& b) {
+        float half = node.size / 2;
+        return (b.x >= node.x + half ? 1 : 0) | (b.y >= node.y + half ? 2 : 0);
+    }
+
+    int childFor(std::vector<Node>& tree, int index, const Body& b) {
+        int q = quadrantOf(tree[index], b);
+        if (tree[index].children[q] < 0) {
+            Node child;
+            float half = tree[index].size / 2;
+            child.x = tree[index].x + (q & 1 ? half : 0);
+            child.y = tree[index].y + (q & 2 ? half : 0);
+            child.size = half;
+            tree.push_back(child);
+            tree[index].children[q] = int(tree.size()) - 1;
+        }
+        return tree[index].children[q];
+    }
+
+    void insert(std::vector<Node>& tree, int bodyIndex) {
+        const Body& b = bodies[bodyIndex];
+        int index = 0;
+        for (int depth = 0;; ++depth) {
+            Node& node = tree[index];
+            bool empty = node.mass == 0;
+            node.mass += b.mass;
+            node.comX += b.x * b.mass;
+            node.comY += b.y * b.mass;
+
+            if (!node.leaf) {
+                index = childFor(tree, index, b);
+                continue;
+            }
+            if (empty) {
+                node.body = bodyIndex;
+                return;
+            }
+            // Bodies stacked closer than the depth limit share one leaf
+            if (depth >= maxDepth) {
+                node.body = -1;
+                return;
+            }
+
+            // Split the leaf: its body moves down a level, then carry on with this one
+            int existing = node.body;
+            node.leaf = false;
+            node.body = -1;
+            if (existing >= 0) {
+                const Body& e = bodies[existing];
+                int child = childFor(tree, index, e);
+                tree[child].mass = e.mass;
+                tree[child].comX = e.x * e.mass;
+                tree[child].comY = e.y * e.mass;
+                tree[child].body = existing;
+            }
+            index = childFor(tree, index, b);
+        }
+    }
+
+    glm::vec3 accelerationOn(int i, std::vector<int>& stack) const {
+        const Body& b = bodies[i];
+        float ax = 0, ay = 0;
+        float soft2 = softening * softening;
+        float theta2 = theta * theta;
+
+        stack.clear();
+        stack.push_back(0);
+        while (!stack.empty()) {
+            const Node& node = nodes[stack.back()];
+            stack.pop_back();
+            if (node.mass <= 0 || node.body == i) continue;
+
+            float dx = node.comX - b.x;
+            float dy = node.comY - b.y;
+            float dist2 = dx * dx + dy * dy + soft2;
+            if (node.leaf || node.size * node.size < theta2 * dist2) {
+                float inv = strength * node.mass / (dist2 * sqrt(dist2));
+                ax += dx * inv;
+                ay += dy * inv;
+            }
+            else {
+                for (int child : node.children) {
+                    if (child >= 0) stack.push_back(child);
+                }
+            }
+        }
+        return glm::vec3(ax, ay, 0);
+    }
+};
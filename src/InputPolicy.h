@@ -0,0 +1,99 @@
+#pragma once
+
+#include "GameWorld.h"
+#include "FastRandom.h"
+#include <string>
+#include <memory>
+
+// Source of player input for worlds nobody is playing (batch runs, soak tests)
+class InputPolicy {
+public:
+    virtual ~InputPolicy() {}
+
+    // Input bitmask for the world's next tick
+    virtual uint8_t nextInput(const GameWorld& world) = 0;
+};
+
+// Mashes random keys, holding each combination for a short random time;
+// uses its own generator so the world's random stream is left alone
+class RandomInputPolicy : public InputPolicy {
+public:
+    RandomInputPolicy(uint64_t seed) : rng(seed) {}
+
+    uint8_t nextInput(const GameWorld& world) override {
+        if (holdTicks <= 0) {
+            input = uint8_t(rng.next(0, 32)) & ~GameWorld::INPUT_QUIT;
+            holdTicks = int(rng.next(5, 40));
+        }
+        holdTicks--;
+        return input;
+    }
+
+private:
+    FastRandom rng;
+    uint8_t input = 0;
+    int holdTicks = 0;
+};
+
+// Fixed pattern: keep firing while turning, with a burst of thrust every
+// few seconds so the ship does not sit still in its invulnerable state
+class ScriptedInputPolicy : public InputPolicy {
+public:
+    uint8_t nextInput(const GameWorld& world) override {
+        uint8_t input = GameWorld::INPUT_SHOOT | GameWorld::INPUT_RIGHT;
+        if (world.tick % 180 < 20) input |= GameWorld::INPUT_FORWARD;
+        return input;
+    }
+};
+
+// Bot that plays the round: fires constantly, turns toward where the
+// nearest asteroid will be when a bullet gets there, and thrusts away
+// from asteroids that are closing in. No randomness, so a soak run is
+// reproducible from its seed.
+class AutopilotPolicy : public InputPolicy {
+public:
+    uint8_t nextInput(const GameWorld& world) override {
+        const Player& player = *world.player;
+        uint8_t input = GameWorld::INPUT_SHOOT;
+        if (player.isExploding) return input;
+
+        // The ship has to move before it loses invulnerability after a respawn
+        if (player.invulnerable) input |= GameWorld::INPUT_BACKWARD;
+
+        CollisionSystem::NearestAsteroid target =
+            CollisionSystem::findNearestAsteroid(player.pos, world.asteroids, world.smallAsteroids);
+        if (!target.found) return input;
+
+        // Lead the target by the bullet's flight time; bullets carry the ship's velocity
+        float flightTime = target.distance / bulletSpeed;
+        glm::vec3 aimPoint = target.pos + (target.velocity - player.velocity) * flightTime;
+        glm::vec3 toAim = aimPoint - player.pos;
+        float aimAngle = glm::degrees(atan2(toAim.y, toAim.x));
+        float turn = fmod(aimAngle - player.rot + 540.0f, 360.0f) - 180.0f;
+        if (turn > aimTolerance) input |= GameWorld::INPUT_RIGHT;
+        else if (turn < -aimTolerance) input |= GameWorld::INPUT_LEFT;
+
+        // Dodge when the asteroid's edge is close and still coming closer
+        glm::vec3 away = player.pos - target.pos;
+        float gap = target.distance - target.radius - player.getRadius();
+        float closing = glm::dot(target.velocity - player.velocity, away);
+        if (gap < dodgeDistance && closing > 0) {
+            float radians = glm::radians(player.rot);
+            glm::vec3 heading(cos(radians), sin(radians), 0);
+            input &= ~(GameWorld::INPUT_FORWARD | GameWorld::INPUT_BACKWARD);
+            input |= glm::dot(heading, away) > 0 ? GameWorld::INPUT_FORWARD : GameWorld::INPUT_BACKWARD;
+        }
+        return input;
+    }
+
+    float bulletSpeed = 8.0f;       // matches the speed GameWorld fires bullets at
+    float aimTolerance = 3.0f;      // degrees off target before turning
+    float dodgeDistance = 80.0f;    // gap to an asteroid's edge that starts a dodge
+};
+
+// Policy by name: "random", "scripted" or "autopilot"
+inline std::unique_ptr<InputPolicy> makeInputPolicy(const std::string& name, uint64_t seed) {
+    if (name == "scripted") return std::unique_ptr<InputPolicy>(new ScriptedInputPolicy());
+    if (name == "autopilot") return std::unique_ptr<InputPolicy>(new AutopilotPolicy());
+    return std::unique_ptr<InputPolicy>(new RandomInputPolicy(seed));
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small persistent worker pool for splitting one job over the cores.
+//
+// run(count, job) calls job(i) for every i in [0, count) on the workers and
+// the calling thread, and returns once all of them are done. Jobs write to
+// their own slots, so results do not depend on which thread ran what. One
+// run at a time: a caller that finds the pool busy (another batch runner
+// thread, say) runs its job on its own thread instead.
+//
+class JobPool {
+public:
+    explicit JobPool(int threads = -1) {
+        if (threads < 0) threads = std::max(0, int(std::thread::hardware_concurrency()) - 1);
+        for (int i = 0; i < threads; ++i) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ~JobPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    JobPool(const JobPool&) = delete;
+    JobPool& operator=(const JobPool&) = delete;
+
+    void run(int count, const std::function<void(int)>& job) {
+        std::unique_lock<std::mutex> runLock(runMutex, std::try_to_lock);
+        if (!runLock.owns_lock() || workers.empty() || count <= 1) {
+            for (int i = 0; i < count; ++i) job(i);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            currentJob = &job;
+            jobCount = count;
+            nextIndex = 0;
+            busyWorkers = int(workers.size());
+            generation++;
+        }
+        wake.notify_all();
+
+        runJobs(job, count);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return busyWorkers == 0; });
+        currentJob = nullptr;
+    }
+
+    int threadCount() const { return int(workers.size()) + 1; }
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex runMutex;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(int)>* currentJob = nullptr;
+    int jobCount = 0;
+    std::atomic<int> nextIndex{ 0 };
+    int busyWorkers = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+
+    void runJobs(const std::function<void(int)>& job, int count) {
+        for (int i = nextIndex++; i < count; i = nextIndex++) {
+            job(i);
+        }
+    }
+
+    void workerLoop() {
+        uint64_t seen = 0;
+        for (;;) {
+            const std::function<void(int)>* job;
+            int count;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+                job = currentJob;
+                count = jobCount;
+            }
+
+            runJobs(*job, count);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                busyWorkers--;
+            }
+            done.notify_one();
+        }
+    }
+};
+
+// Pool shared by the simulation's parallel passes, one worker per extra core
+inline JobPool& sharedJobPool() {
+    static JobPool pool;
+    return pool;
+}
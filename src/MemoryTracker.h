@@ -0,0 +1,209 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <ostream>
+
+// Heap accounting by subsystem.
+//
+// main.cpp replaces the global operator new and delete with allocate() and
+// release() below. Every block gets a small header holding its size and the
+// tag that was current on the allocating thread, so a free is charged back
+// to the subsystem that allocated the block, wherever it happens. Code sets
+// the tag with a MemoryScope around the calls whose allocations belong to a
+// subsystem; the innermost scope wins and anything outside a scope counts
+// as OTHER. Over-aligned allocations (alignas > 16) go through
+// allocateAligned(), which pads the block so the header still sits right
+// in front of the aligned pointer.
+//
+// MemoryStats samples the counters once a frame for the debug overlay and
+// writes the report behind F7 and --memory-report.
+//
+enum class MemoryTag : uint8_t {
+    OTHER,
+    WORLD,          // entity arrays, timers, events, snapshots
+    SHAPES,         // asteroid outlines
+    PARTICLES,      // bullets and explosion particles
+    COLLISION,      // broadphase grid and scratch
+    RENDER,         // render queue and culling lists
+    ASSETS,         // images, fonts and sounds loaded at startup
+    UI,             // HUD and overlay text
+    TELEMETRY,      // telemetry ring, write batches and file buffers
+    COUNT
+};
+
+namespace MemoryTracker {
+    static const int numTags = int(MemoryTag::COUNT);
+
+    inline const char* tagName(MemoryTag tag) {
+        static const char* names[numTags] = { "other", "world", "shapes", "particles", "collision", "render", "assets", "ui", "telemetry" };
+        return names[int(tag)];
+    }
+
+    // Running totals for one tag, updated from any thread
+    struct Counters {
+        std::atomic<int64_t> liveBytes{ 0 };
+        std::atomic<int64_t> peakBytes{ 0 };
+        std::atomic<int64_t> liveBlocks{ 0 };
+        std::atomic<uint64_t> allocations{ 0 };
+    };
+
+    inline Counters* counters() {
+        static Counters perTag[numTags];
+        return perTag;
+    }
+
+    inline MemoryTag& currentTag() {
+        thread_local MemoryTag tag = MemoryTag::OTHER;
+        return tag;
+    }
+
+    // In front of every counted block; 16 bytes keeps malloc's alignment.
+    // offset is how far the caller's pointer is from the malloc'd block
+    struct alignas(16) Header {
+        uint64_t size;
+        uint32_t offset;
+        MemoryTag tag;
+    };
+
+    inline void count(Header* header, size_t size, size_t offset) {
+        header->size = size;
+        header->offset = uint32_t(offset);
+        header->tag = currentTag();
+
+        Counters& c = counters()[int(header->tag)];
+        int64_t live = c.liveBytes.fetch_add(int64_t(size), std::memory_order_relaxed) + int64_t(size);
+        int64_t peak = c.peakBytes.load(std::memory_order_relaxed);
+        while (live > peak && !c.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+        c.liveBlocks.fetch_add(1, std::memory_order_relaxed);
+        c.allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    inline void* allocate(size_t size) {
+        Header* header = static_cast<Header*>(std::malloc(sizeof(Header) + size));
+        if (!header) return nullptr;
+        count(header, size, sizeof(Header));
+        return header + 1;
+    }
+
+    // For alignments above the header's 16: enough padding that an aligned
+    // pointer with room for the header in front of it always fits
+    inline void* allocateAligned(size_t size, size_t alignment) {
+        if (alignment <= alignof(Header)) return allocate(size);
+        char* block = static_cast<char*>(std::malloc(sizeof(Header) + alignment + size));
+        if (!block) return nullptr;
+        uintptr_t first = reinterpret_cast<uintptr_t>(block) + sizeof(Header);
+        char* p = reinterpret_cast<char*>((first + alignment - 1) & ~uintptr_t(alignment - 1));
+        count(reinterpret_cast<Header*>(p) - 1, size, size_t(p - block));
+        return p;
+    }
+
+    inline void release(void* p) {
+        if (!p) return;
+        Header* header = static_cast<Header*>(p) - 1;
+        Counters& c = counters()[int(header->tag)];
+        c.liveBytes.fetch_sub(int64_t(header->size), std::memory_order_relaxed);
+        c.liveBlocks.fetch_sub(1, std::memory_order_relaxed);
+        std::free(static_cast<char*>(p) - header->offset);
+    }
+}
+
+// Allocations on this thread are charged to tag until the scope ends
+class MemoryScope {
+public:
+    explicit MemoryScope(MemoryTag tag) : previous(MemoryTracker::currentTag()) {
+        MemoryTracker::currentTag() = tag;
+    }
+    ~MemoryScope() {
+        MemoryTracker::currentTag() = previous;
+    }
+    MemoryScope(const MemoryScope&) = delete;
+    MemoryScope& operator=(const MemoryScope&) = delete;
+
+private:
+    MemoryTag previous;
+};
+
+// Per-frame view of the counters: sample() once a frame gives each tag's
+// allocations since the previous sample, and growth is measured from the
+// last markBaseline() (the start of a round)
+class MemoryStats {
+public:
+    struct Tag {
+        int64_t liveBytes = 0;
+        int64_t peakBytes = 0;
+        int64_t liveBlocks = 0;
+        uint64_t allocations = 0;           // since startup
+        uint64_t recentAllocations = 0;     // between the last two samples, one frame in the game
+        int64_t baselineBytes = 0;
+    };
+
+    Tag tags[MemoryTracker::numTags];
+
+    void sample() {
+        for (int i = 0; i < MemoryTracker::numTags; ++i) {
+            const MemoryTracker::Counters& c = MemoryTracker::counters()[i];
+            Tag& t = tags[i];
+            uint64_t allocations = c.allocations.load(std::memory_order_relaxed);
+            t.recentAllocations = allocations - t.allocations;
+            t.allocations = allocations;
+            t.liveBytes = c.liveBytes.load(std::memory_order_relaxed);
+            t.peakBytes = c.peakBytes.load(std::memory_order_relaxed);
+            t.liveBlocks = c.liveBlocks.load(std::memory_order_relaxed);
+        }
+    }
+
+    void markBaseline() {
+        sample();
+        for (Tag& t : tags) t.baselineBytes = t.liveBytes;
+    }
+
+    int64_t totalLiveBytes() const {
+        int64_t total = 0;
+        for (const Tag& t : tags) total += t.liveBytes;
+        return total;
+    }
+
+    uint64_t totalRecentAllocations() const {
+        uint64_t total = 0;
+        for (const Tag& t : tags) total += t.recentAllocations;
+        return total;
+    }
+
+    int64_t growthBytes() const {
+        int64_t total = 0;
+        for (const Tag& t : tags) total += t.liveBytes - t.baselineBytes;
+        return total;
+    }
+
+    // Sum of the tags' peaks, an upper bound on the true peak
+    int64_t totalPeakBytes() const {
+        int64_t total = 0;
+        for (const Tag& t : tags) total += t.peakBytes;
+        return total;
+    }
+
+    // One line per tag as of the last sample, largest first
+    void report(std::ostream& out) const {
+        int order[MemoryTracker::numTags];
+        for (int i = 0; i < MemoryTracker::numTags; ++i) order[i] = i;
+        std::sort(order, order + MemoryTracker::numTags, [this](int a, int b) { return tags[a].liveBytes > tags[b].liveBytes; });
+
+        char line[160];
+        out << "tag        live KB    peak KB     blocks   growth KB   allocations      recent\n";
+        for (int i : order) {
+            const Tag& t = tags[i];
+            snprintf(line, sizeof(line), "%-9s %8.1f %10.1f %10lld %11.1f %13llu %11llu\n", MemoryTracker::tagName(MemoryTag(i)),
+                t.liveBytes / 1024.0, t.peakBytes / 1024.0, (long long)t.liveBlocks, (t.liveBytes - t.baselineBytes) / 1024.0,
+                (unsigned long long)t.allocations, (unsigned long long)t.recentAllocations);
+            out << line;
+        }
+        snprintf(line, sizeof(line), "total     %8.1f KB live, %.1f KB growth, %llu recent allocations\n",
+            totalLiveBytes() / 1024.0, growthBytes() / 1024.0, (unsigned long long)totalRecentAllocations());
+        out << line;
+    }
+};
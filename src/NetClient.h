@@ -0,0 +1,347 @@
+#pragma once
+
+#include "ofMain.h"
+#include "GameWorld.h"
+#include "NetSocket.h"
+#include "NetSnapshot.h"
+#include "RenderQueue.h"
+#include <chrono>
+#include <unordered_map>
+#include <vector>
+
+// Client for localhost multiplayer: sends input, keeps the states the
+// server sends and shows the world delayTicks behind the newest one,
+// interpolating between the two states around the render time so motion
+// stays smooth when packets arrive unevenly. Positions interpolate the short
+// way around the wrapping world; anything that moved further than a
+// teleport (a respawn) snaps. Explosions are drawn locally as rings growing
+// from where the server says something blew up.
+//
+class NetClient {
+public:
+    static const int historySize = 64;          // by tick % historySize, matches the server's
+    int delayTicks = 6;
+
+    // Interpolated world at the render time, in world coordinates
+    struct Pose {
+        glm::vec3 pos;
+        float rot;
+        uint8_t flags;
+        uint32_t id;
+    };
+
+    struct Frame {
+        std::vector<Pose> ships;
+        std::vector<Pose> asteroids;
+        std::vector<Pose> bullets;
+        int score = 0;
+        float timeLeft = 0;
+    };
+
+    struct Stats {
+        uint64_t states = 0, bytes = 0;
+        uint64_t rejected = 0;          // malformed, late or missing their baseline
+        uint64_t underruns = 0;         // frames that caught up with the newest state
+        double decodeSeconds = 0;
+    };
+
+    ~NetClient() {
+        disconnect();
+    }
+
+    bool connect(uint16_t port) {
+        if (!socket.open(0)) return false;
+        server = UdpSocket::localhost(port);
+        ship = -1;
+        newestTick = 0;
+        helloWait = 0;
+        for (Net::WorldState& s : history) s.tick = 0;
+        return true;
+    }
+
+    void disconnect() {
+        if (!socket.isOpen()) return;
+        uint8_t bye = Net::BYE;
+        socket.send(server, &bye, 1);
+        socket.close();
+    }
+
+    bool isOpen() const { return socket.isOpen(); }
+    bool hasFrame() const { return ship >= 0 && newestTick != 0; }
+
+    // One frame: reads what arrived, sends input with the newest tick
+    // received and moves the render time on by dt seconds
+    void update(uint8_t input, float dt) {
+        receive();
+
+        if (ship < 0) {
+            // Ask for a ship twice a second until the server answers
+            helloWait -= dt;
+            if (helloWait <= 0) {
+                uint8_t hello = Net::HELLO;
+                socket.send(server, &hello, 1);
+                helloWait = 0.5f;
+            }
+            return;
+        }
+
+        std::vector<uint8_t> out;
+        Net::ByteWriter w(out);
+        w.u8(Net::INPUT);
+        w.u32(newestTick);
+        w.u8(input);
+        socket.send(server, out.data(), out.size());
+
+        if (newestTick == 0) return;
+        double target = double(newestTick) - delayTicks;
+        renderTick += dt * TimerWheel::ticksPerSecond;
+        if (renderTick < target - 30 || renderTick > newestTick + 30) {
+            renderTick = target;
+        }
+        else {
+            renderTick += (target - renderTick) * 0.05;
+        }
+        if (renderTick > newestTick) {
+            stats.underruns++;
+            renderTick = newestTick;
+        }
+        interpolate();
+    }
+
+    // Frame's ships, asteroids and bullets through the render queue
+    void draw(const ofRectangle& view, RenderBackend& backend) {
+        queue.begin();
+        queue.setOffset(glm::vec3(0, 0, 0));
+
+        for (const Pose& a : frame.asteroids) {
+            if (!inView(view, a.pos, 160)) continue;
+            if (a.flags & Net::ENTITY_EXPLODING) {
+                drawRing(a.pos, explosionAge(a.id), ofColor(255));
+                continue;
+            }
+            auto shape = shapes.find(a.id);
+            if (shape == shapes.end() || shape->second.radii.empty()) continue;
+            const std::vector<uint8_t>& radii = shape->second.radii;
+            float angleStep = TWO_PI / radii.size();
+            float turn = glm::radians(a.rot);
+            glm::vec3* v = queue.lines(RenderQueue::LAYER_ASTEROIDS, ofColor(255), radii.size() * 2);
+            for (size_t i = 0; i < radii.size(); ++i) {
+                size_t next = i + 1 == radii.size() ? 0 : i + 1;
+                *v++ = a.pos + glm::vec3(cos(turn + i * angleStep), sin(turn + i * angleStep), 0) * float(radii[i]);
+                *v++ = a.pos + glm::vec3(cos(turn + next * angleStep), sin(turn + next * angleStep), 0) * float(radii[next]);
+            }
+        }
+
+        for (size_t i = 0; i < frame.ships.size(); ++i) {
+            const Pose& s = frame.ships[i];
+            ofColor color = GameWorld::shipColors()[i];
+            if (s.flags & Net::SHIP_EXPLODING) {
+                drawRing(s.pos, float(renderTick) - shipExplodedAt[i], color);
+                continue;
+            }
+            if (s.flags & Net::SHIP_INVULNERABLE) color = ofColor(255, 127 + 127 * sin(float(renderTick) * 0.1f));
+
+            const glm::vec3 shape[6] = {
+                glm::vec3(-10, 10, 0), glm::vec3(10, 0, 0),
+                glm::vec3(10, 0, 0), glm::vec3(-10, -10, 0),
+                glm::vec3(-10, -10, 0), glm::vec3(-10, 10, 0)
+            };
+            float radians = glm::radians(s.rot);
+            float c = cos(radians), sn = sin(radians);
+            glm::vec3* v = queue.lines(RenderQueue::LAYER_PLAYER, color, 6);
+            for (const glm::vec3& point : shape) {
+                *v++ = s.pos + glm::vec3(point.x * c - point.y * sn, point.x * sn + point.y * c, 0);
+            }
+        }
+
+        if (!frame.bullets.empty()) {
+            glm::vec3* v = queue.lines(RenderQueue::LAYER_BULLETS, ofColor(0, 255, 0), frame.bullets.size() * 2);
+            for (const Pose& b : frame.bullets) {
+                glm::vec3 half(cos(glm::radians(b.rot)) * 2.0f, sin(glm::radians(b.rot)) * 2.0f, 0);
+                *v++ = b.pos - half;
+                *v++ = b.pos + half;
+            }
+        }
+
+        queue.flush(backend);
+    }
+
+    // Window-sized view following this client's ship, kept inside the world
+    ofRectangle cameraView(float width, float height) const {
+        glm::vec3 center = ship >= 0 && ship < int(frame.ships.size()) ? frame.ships[ship].pos : glm::vec3(worldSize.x / 2, worldSize.y / 2, 0);
+        float x = ofClamp(center.x - width / 2, 0, std::max(0.0f, worldSize.x - width));
+        float y = ofClamp(center.y - height / 2, 0, std::max(0.0f, worldSize.y - height));
+        return ofRectangle(x, y, width, height);
+    }
+
+    int ship = -1;                      // ours, -1 until the server welcomes us
+    glm::vec2 worldSize = glm::vec2(1200, 720);
+    Frame frame;
+    Stats stats;
+
+private:
+    UdpSocket socket;
+    UdpSocket::Address server;
+    std::vector<Net::WorldState> history = std::vector<Net::WorldState>(historySize);
+    std::unordered_map<uint32_t, Net::Outline> shapes;
+    std::unordered_map<uint32_t, uint32_t> explodedAt;     // asteroid id -> first state it was exploding in
+    uint32_t shipExplodedAt[GameWorld::maxShips] = {};
+    uint32_t newestTick = 0;
+    double renderTick = 0;
+    float helloWait = 0;
+    Net::WorldState decoded;
+    RenderQueue queue;
+
+    const Net::WorldState* stateAt(uint32_t tick) const {
+        const Net::WorldState& s = history[tick % historySize];
+        return tick != 0 && s.tick == tick ? &s : nullptr;
+    }
+
+    void receive() {
+        uint8_t buffer[65536];
+        UdpSocket::Address from;
+        while (size_t size = socket.receive(buffer, sizeof(buffer), from)) {
+            if (from != server) continue;
+            if (buffer[0] == Net::WELCOME) {
+                Net::ByteReader r(buffer + 1, size - 1);
+                uint8_t given = r.u8();
+                glm::vec2 size2(r.f32(), r.f32());
+                if (!r.ok || given == Net::noShip) continue;
+                ship = given;
+                worldSize = size2;
+            }
+            else if (buffer[0] == Net::STATE && ship >= 0) {
+                auto start = std::chrono::steady_clock::now();
+                bool ok = NetSnapshot::decode(buffer, size, [this](uint32_t tick) { return stateAt(tick); }, decoded, shapes);
+                stats.decodeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                if (!ok || decoded.tick <= newestTick) {
+                    stats.rejected++;
+                    continue;
+                }
+                stats.states++;
+                stats.bytes += size;
+                noteExplosions(decoded);
+                newestTick = decoded.tick;
+                std::swap(history[newestTick % historySize], decoded);
+                forget();
+            }
+        }
+    }
+
+    // When each explosion started, for the growing rings. Ids restart every
+    // round, so an id that was not exploding in the newest state so far
+    // starts a new explosion even if an old one is still on record
+    void noteExplosions(const Net::WorldState& s) {
+        static const std::vector<Net::EntityState> none;
+        const Net::WorldState* previous = stateAt(newestTick);
+        const std::vector<Net::EntityState>& before = previous ? previous->entities : none;
+        size_t j = 0;
+        for (const Net::EntityState& e : s.entities) {
+            if (!(e.flags & Net::ENTITY_EXPLODING)) continue;
+            while (j < before.size() && before[j].id < e.id) j++;
+            bool wasExploding = j < before.size() && before[j].id == e.id && (before[j].flags & Net::ENTITY_EXPLODING);
+            if (!wasExploding) explodedAt[e.id] = s.tick;
+        }
+        for (size_t i = 0; i < s.ships.size() && i < GameWorld::maxShips; ++i) {
+            if (!(s.ships[i].flags & Net::SHIP_EXPLODING)) shipExplodedAt[i] = 0;
+            else if (shipExplodedAt[i] == 0) shipExplodedAt[i] = s.tick;
+        }
+    }
+
+    // Outlines and explosion starts of asteroids no kept state still holds
+    void forget() {
+        for (auto it = shapes.begin(); it != shapes.end();) {
+            if (it->second.removedTick != 0 && it->second.removedTick + historySize < newestTick) {
+                explodedAt.erase(it->first);
+                it = shapes.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+    float explosionAge(uint32_t id) const {
+        auto it = explodedAt.find(id);
+        return it == explodedAt.end() ? 0 : float(renderTick) - it->second;
+    }
+
+    // Expanding ring that fades over a second and a half
+    void drawRing(const glm::vec3& center, float age, ofColor color) {
+        const float lifetime = 90.0f;
+        if (age < 0 || age > lifetime) return;
+        const int segments = 16;
+        float radius = 10.0f + age * 1.5f;
+        color.a = (unsigned char)(255 * (1 - age / lifetime));
+        glm::vec3* v = queue.lines(RenderQueue::LAYER_EXPLOSIONS, color, segments * 2);
+        for (int i = 0; i < segments; ++i) {
+            float a0 = TWO_PI * i / segments, a1 = TWO_PI * (i + 1) / segments;
+            *v++ = center + glm::vec3(cos(a0), sin(a0), 0) * radius;
+            *v++ = center + glm::vec3(cos(a1), sin(a1), 0) * radius;
+        }
+    }
+
+    static bool inView(const ofRectangle& view, const glm::vec3& p, float margin) {
+        return p.x + margin >= view.getLeft() && p.x - margin <= view.getRight() && p.y + margin >= view.getTop() && p.y - margin <= view.getBottom();
+    }
+
+    // Quantized coordinate a fraction t of the short way from a to b; jumps
+    // of more than a sixteenth of the world are respawns and snap to b
+    static float lerpWrapped(uint16_t a, uint16_t b, float t, float size) {
+        int16_t delta = int16_t(uint16_t(b - a));
+        if (delta > 4096 || delta < -4096) return Net::dequantize(b, size);
+        float q = a + delta * t;
+        if (q < 0) q += 65536.0f;
+        else if (q >= 65536.0f) q -= 65536.0f;
+        return q * size / 65536.0f;
+    }
+
+    static float lerpAngle(uint8_t a, uint8_t b, float t) {
+        int8_t delta = int8_t(uint8_t(b - a));
+        return (a + delta * t) * 360.0f / 256.0f;
+    }
+
+    Pose pose(uint16_t ax, uint16_t ay, uint8_t arot, uint16_t bx, uint16_t by, uint8_t brot, float t, uint8_t flags, uint32_t id) const {
+        return { glm::vec3(lerpWrapped(ax, bx, t, worldSize.x), lerpWrapped(ay, by, t, worldSize.y), 0), lerpAngle(arot, brot, t), flags, id };
+    }
+
+    // Frame from the kept states either side of renderTick
+    void interpolate() {
+        uint32_t tick = uint32_t(renderTick);
+        const Net::WorldState* a = nullptr;
+        const Net::WorldState* b = nullptr;
+        for (uint32_t back = 0; back < historySize && !a && back <= tick; ++back) a = stateAt(tick - back);
+        for (uint32_t ahead = 1; ahead < historySize && !b && tick + ahead <= newestTick; ++ahead) b = stateAt(tick + ahead);
+        if (!a) a = b ? b : stateAt(newestTick);
+        if (!b) b = a;
+        if (!a) return;
+        float t = b->tick > a->tick ? float((renderTick - a->tick) / (b->tick - a->tick)) : 0.0f;
+        t = ofClamp(t, 0, 1);
+
+        frame.score = b->score;
+        frame.timeLeft = b->timeLeft / 10.0f;
+
+        frame.ships.clear();
+        for (size_t i = 0; i < b->ships.size(); ++i) {
+            const Net::ShipState& to = b->ships[i];
+            const Net::ShipState& from = i < a->ships.size() ? a->ships[i] : to;
+            frame.ships.push_back(pose(from.x, from.y, from.rot, to.x, to.y, to.rot, t, to.flags, uint32_t(i)));
+        }
+
+        // Asteroids matched by id; ones only in the later state appear as they are
+        frame.asteroids.clear();
+        size_t j = 0;
+        for (const Net::EntityState& to : b->entities) {
+            while (j < a->entities.size() && a->entities[j].id < to.id) j++;
+            const Net::EntityState& from = j < a->entities.size() && a->entities[j].id == to.id ? a->entities[j] : to;
+            frame.asteroids.push_back(pose(from.x, from.y, from.rot, to.x, to.y, to.rot, t, to.flags, to.id));
+        }
+
+        // Bullets have no ids, so they come from the nearer state
+        frame.bullets.clear();
+        for (const Net::BulletState& bullet : (t < 0.5f ? a : b)->bullets) {
+            frame.bullets.push_back({ glm::vec3(Net::dequantize(bullet.x, worldSize.x), Net::dequantize(bullet.y, worldSize.y), 0),
+                Net::dequantizeAngle(bullet.rot), 0, 0 });
+        }
+    }
+};
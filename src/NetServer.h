@@ -0,0 +1,208 @@
+#pragma once
+
+#include "GameWorld.h"
+#include "NetSocket.h"
+#include "NetSnapshot.h"
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Authoritative server for localhost multiplayer.
+//
+// Runs the world at the fixed 60 Hz tick with 2 - 4 ships. A client joins
+// with HELLO and is given the lowest free ship; from then on it sends its
+// input bits every frame along with the newest state it has received. The
+// last input heard from each client is held until a newer one arrives, and
+// ships nobody controls sit still. Every tick each client is sent the
+// world's state, delta coded against the state it acknowledged (see
+// NetSnapshot.h); clients silent for timeoutTicks lose their ship. When a
+// round ends the next starts with the following seed and every client gets
+// a full state. Once a second the server prints bandwidth and encode cost.
+//
+class NetServer {
+public:
+    struct Settings {
+        uint16_t port = Net::defaultPort;
+        int ships = 2;
+        uint64_t seed = 1;
+        float width = 1200, height = 720;
+        float seconds = 0;          // stop after this long, 0 runs until killed
+    };
+
+    static const int historySize = 64;          // states kept per client for acknowledgements, about a second
+    static const uint32_t timeoutTicks = 300;
+
+    // Balance settings can be changed before start()
+    GameWorld world;
+
+    bool start(const Settings& settings) {
+        this->settings = settings;
+        this->settings.ships = std::max(2, std::min(GameWorld::maxShips, settings.ships));
+        if (!socket.open(settings.port)) {
+            std::cerr << "could not open UDP port " << settings.port << std::endl;
+            return false;
+        }
+        world.shipCount = this->settings.ships;
+        world.start(settings.seed, settings.width, settings.height);
+        round = 0;
+        netTick = 0;
+        roundStart = 1;
+        clients.clear();
+        std::cout << "server on port " << settings.port << ", " << this->settings.ships << " ships" << std::endl;
+        return true;
+    }
+
+    // Ticks at 60 Hz until settings.seconds have passed
+    int run() {
+        typedef std::chrono::steady_clock Clock;
+        auto tickLength = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / TimerWheel::ticksPerSecond));
+        auto next = Clock::now();
+        uint32_t lastTick = settings.seconds > 0 ? TimerWheel::secondsToTicks(settings.seconds) : 0;
+        while (lastTick == 0 || netTick < lastTick) {
+            tick();
+            next += tickLength;
+            std::this_thread::sleep_until(next);
+        }
+        return 0;
+    }
+
+    // Reads every waiting packet, steps the world and sends each client its state
+    void tick() {
+        netTick++;
+        receive();
+
+        // Drop clients that went quiet
+        clients.erase(std::remove_if(clients.begin(), clients.end(), [this](const Client& c) {
+            return netTick - c.lastHeard > timeoutTicks;
+        }), clients.end());
+
+        uint8_t inputs[GameWorld::maxShips] = {};
+        for (const Client& c : clients) inputs[c.ship] = c.input;
+        world.step(inputs, world.numShips());
+        if (world.timesUp) {
+            world.start(settings.seed + ++round, settings.width, settings.height);
+            roundStart = netTick;
+        }
+
+        auto encodeStart = std::chrono::steady_clock::now();
+        NetSnapshot::capture(world, netTick, state);
+        for (Client& c : clients) {
+            const Net::WorldState* baseline = nullptr;
+            const Net::WorldState& acked = c.sent[c.ackTick % historySize];
+            bool usable = c.ackTick >= roundStart && netTick - c.ackTick < historySize && acked.tick == c.ackTick;
+            if (usable) baseline = &acked;
+            else stats.fullStates++;
+
+            NetSnapshot::encode(world, state, baseline, packet, c.sent[netTick % historySize]);
+            socket.send(c.address, packet.data(), packet.size());
+            stats.states++;
+            stats.bytes += packet.size();
+            stats.largest = std::max(stats.largest, packet.size());
+        }
+        stats.encodeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - encodeStart).count();
+        stats.ticks++;
+
+        if (stats.ticks == TimerWheel::ticksPerSecond) {
+            report();
+            stats = Stats();
+        }
+    }
+
+private:
+    struct Client {
+        UdpSocket::Address address;
+        int ship = 0;
+        uint8_t input = 0;
+        uint32_t ackTick = 0;           // newest state the client has, 0 for none
+        uint32_t lastHeard = 0;
+        std::vector<Net::WorldState> sent = std::vector<Net::WorldState>(historySize);     // by tick % historySize
+    };
+
+    struct Stats {
+        uint32_t ticks = 0;
+        uint64_t states = 0, fullStates = 0, bytes = 0;
+        size_t largest = 0;
+        double encodeSeconds = 0;
+    };
+
+    Settings settings;
+    UdpSocket socket;
+    std::vector<Client> clients;
+    uint32_t netTick = 0;               // never restarts, unlike world.tick
+    uint64_t round = 0;
+    uint32_t roundStart = 1;            // asteroid ids restart with each round, so older states are no baseline
+    Net::WorldState state;
+    std::vector<uint8_t> packet;
+    Stats stats;
+
+    Client* find(const UdpSocket::Address& address) {
+        for (Client& c : clients) {
+            if (c.address == address) return &c;
+        }
+        return nullptr;
+    }
+
+    void receive() {
+        uint8_t buffer[256];
+        UdpSocket::Address from;
+        while (size_t size = socket.receive(buffer, sizeof(buffer), from)) {
+            Net::ByteReader r(buffer, size);
+            uint8_t type = r.u8();
+            Client* client = find(from);
+
+            if (type == Net::HELLO) {
+                if (!client) client = join(from);
+                welcome(from, client ? uint8_t(client->ship) : Net::noShip);
+            }
+            else if (type == Net::INPUT && client) {
+                uint32_t ack = r.u32();
+                uint8_t input = r.u8();
+                if (!r.ok) continue;
+                if (ack > client->ackTick && ack <= netTick) client->ackTick = ack;
+                client->input = input & ~GameWorld::INPUT_QUIT;    // one player cannot end everyone's round
+                client->lastHeard = netTick;
+            }
+            else if (type == Net::BYE && client) {
+                std::cout << "ship " << client->ship << " left" << std::endl;
+                clients.erase(clients.begin() + (client - clients.data()));
+            }
+        }
+    }
+
+    // Lowest ship nobody has, null when all are taken
+    Client* join(const UdpSocket::Address& address) {
+        for (int ship = 0; ship < world.numShips(); ++ship) {
+            bool taken = false;
+            for (const Client& c : clients) taken |= c.ship == ship;
+            if (taken) continue;
+
+            Client c;
+            c.address = address;
+            c.ship = ship;
+            c.lastHeard = netTick;
+            clients.push_back(std::move(c));
+            std::cout << "ship " << ship << " joined" << std::endl;
+            return &clients.back();
+        }
+        return nullptr;
+    }
+
+    void welcome(const UdpSocket::Address& to, uint8_t ship) {
+        std::vector<uint8_t> out;
+        Net::ByteWriter w(out);
+        w.u8(Net::WELCOME);
+        w.u8(ship);
+        w.f32(world.worldSize.x);
+        w.f32(world.worldSize.y);
+        socket.send(to, out.data(), out.size());
+    }
+
+    void report() {
+        double states = double(std::max<uint64_t>(1, stats.states));
+        std::cout << "tick " << netTick << ", " << clients.size() << " clients, " << world.asteroids.size() << "/"
+            << world.smallAsteroids.size() << " asteroids: " << stats.bytes / states << " bytes per state (largest "
+            << stats.largest << ", " << stats.fullStates << " full), " << stats.bytes * 8 / 1000.0 / std::max<size_t>(1, clients.size())
+            << " kbit/s per client, capture + encode " << stats.encodeSeconds * 1e6 / stats.ticks << " us per tick" << std::endl;
+    }
+};
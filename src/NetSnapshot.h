@@ -0,0 +1,411 @@
+#pragma once
+
+#include "GameWorld.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+// Wire format of the localhost multiplayer mode.
+//
+// Every datagram starts with a packet type byte:
+//   HELLO    client -> server, asks for a ship
+//   WELCOME  server -> client: ship index (noShip when full), world size
+//   INPUT    client -> server: newest state tick received, input bits
+//   STATE    server -> client: the world at one tick
+//   BYE      client -> server, leaving
+//
+// States are quantized: positions are uint16 fractions of the world size
+// and rotations a byte. Ships and bullets are sent whole every tick.
+// Asteroids carry a stable id and are delta coded against the newest state
+// the client has acknowledged: only new asteroids, changed fields and
+// removed ids are written, ids as varint gaps in ascending order and
+// positions as wrapped varint differences. An asteroid's outline is sent
+// once, in the state it first appears in, as one radius byte per corner. A
+// split shows up as the parent turning into an explosion and three new
+// small ids.
+//
+namespace Net {
+    static const uint16_t defaultPort = 27960;
+    static const size_t maxPacketSize = 60000;     // a bigger state leaves new asteroids for later ticks
+    static const uint8_t noShip = 0xFF;
+
+    enum PacketType : uint8_t { HELLO = 1, WELCOME, INPUT, STATE, BYE };
+
+    enum ShipFlags : uint8_t { SHIP_EXPLODING = 1, SHIP_INVULNERABLE = 2 };
+    enum EntityFlags : uint8_t { ENTITY_SMALL = 1, ENTITY_EXPLODING = 2 };
+
+    // Fields written for an asteroid in a delta
+    enum FieldMask : uint8_t { FIELD_X = 1, FIELD_Y = 2, FIELD_ROT = 4, FIELD_FLAGS = 8, FIELD_NEW = 16 };
+
+    struct ShipState {
+        uint16_t x, y;
+        uint8_t rot, flags;
+    };
+
+    struct BulletState {
+        uint16_t x, y;
+        uint8_t rot;
+    };
+
+    struct EntityState {
+        uint32_t id;
+        uint16_t x, y;              // the explosion centre once exploding
+        uint8_t rot, flags;
+        int32_t index;              // into the world's asteroids or small asteroids, server side only
+    };
+
+    // Outline as the distance in pixels to each corner, corners evenly spaced around the centre
+    struct Outline {
+        std::vector<uint8_t> radii;
+        uint32_t removedTick = 0;   // state that removed the asteroid, 0 while it is in play
+    };
+
+    struct WorldState {
+        uint32_t tick = 0;          // 0 marks an empty history slot
+        int32_t score = 0;
+        uint16_t timeLeft = 0;      // tenths of a second
+        bool timesUp = false;
+        std::vector<ShipState> ships;
+        std::vector<BulletState> bullets;
+        std::vector<EntityState> entities;     // ascending id
+    };
+
+    class ByteWriter {
+    public:
+        explicit ByteWriter(std::vector<uint8_t>& out) : out(out) {}
+
+        void u8(uint8_t v) { out.push_back(v); }
+        void u16(uint16_t v) { u8(uint8_t(v)); u8(uint8_t(v >> 8)); }
+        void u32(uint32_t v) { u16(uint16_t(v)); u16(uint16_t(v >> 16)); }
+        void f32(float v) { uint32_t bits; std::memcpy(&bits, &v, 4); u32(bits); }
+        void bytes(const std::vector<uint8_t>& v) { out.insert(out.end(), v.begin(), v.end()); }
+
+        void varint(uint32_t v) {
+            while (v >= 0x80) {
+                u8(uint8_t(v | 0x80));
+                v >>= 7;
+            }
+            u8(uint8_t(v));
+        }
+
+        // Small values of either sign in few bytes
+        void svarint(int32_t v) { varint((uint32_t(v) << 1) ^ uint32_t(v >> 31)); }
+
+        size_t size() const { return out.size(); }
+
+    private:
+        std::vector<uint8_t>& out;
+    };
+
+    // Reads past the end return 0 and clear ok
+    class ByteReader {
+    public:
+        ByteReader(const uint8_t* data, size_t size) : p(data), end(data + size) {}
+
+        uint8_t u8() {
+            if (p >= end) {
+                ok = false;
+                return 0;
+            }
+            return *p++;
+        }
+        uint16_t u16() { uint16_t lo = u8(); return uint16_t(lo | (u8() << 8)); }
+        uint32_t u32() { uint32_t lo = u16(); return lo | (uint32_t(u16()) << 16); }
+        float f32() { uint32_t bits = u32(); float v; std::memcpy(&v, &bits, 4); return v; }
+
+        uint32_t varint() {
+            uint32_t v = 0;
+            for (int shift = 0; shift < 35; shift += 7) {
+                uint8_t b = u8();
+                v |= uint32_t(b & 0x7F) << shift;
+                if (!(b & 0x80)) return v;
+            }
+            ok = false;
+            return 0;
+        }
+        int32_t svarint() { uint32_t v = varint(); return int32_t(v >> 1) ^ -int32_t(v & 1); }
+
+        size_t remaining() const { return size_t(end - p); }
+        bool atEnd() const { return p == end; }
+
+        bool ok = true;
+
+    private:
+        const uint8_t* p;
+        const uint8_t* end;
+    };
+
+    inline uint16_t quantize(float v, float size) { return uint16_t(int(v / size * 65536.0f) & 0xFFFF); }
+    inline float dequantize(uint16_t q, float size) { return q * size / 65536.0f; }
+    inline uint8_t quantizeAngle(float degrees) { return uint8_t(int(floor(degrees / 360.0f * 256.0f)) & 0xFF); }
+    inline float dequantizeAngle(uint8_t q) { return q * 360.0f / 256.0f; }
+}
+
+class NetSnapshot {
+public:
+    // The world as its quantized network state
+    static void capture(const GameWorld& world, uint32_t tick, Net::WorldState& out) {
+        using namespace Net;
+        float width = world.worldSize.x, height = world.worldSize.y;
+        out.tick = tick;
+        out.score = world.score;
+        out.timeLeft = uint16_t(ofClamp(world.timer, 0, 6553.0f) * 10);
+        out.timesUp = world.timesUp;
+
+        out.ships.clear();
+        for (int i = 0; i < world.numShips(); ++i) {
+            const Player& ship = world.ship(i);
+            uint8_t flags = (ship.isExploding ? SHIP_EXPLODING : 0) | (ship.invulnerable ? SHIP_INVULNERABLE : 0);
+            out.ships.push_back({ quantize(ship.pos.x, width), quantize(ship.pos.y, height), quantizeAngle(ship.rot), flags });
+        }
+
+        out.bullets.clear();
+        const BulletStore& bullets = world.bullets;
+        for (size_t i = 0; i < bullets.size(); ++i) {
+            glm::vec3 pos = bullets.position(i);
+            out.bullets.push_back({ quantize(pos.x, width), quantize(pos.y, height), quantizeAngle(bullets.angle(i)) });
+        }
+
+        out.entities.clear();
+        for (size_t i = 0; i < world.asteroids.size(); ++i) {
+            out.entities.push_back(entityOf(world.asteroids[i], 0, int32_t(i), world.worldSize));
+        }
+        for (size_t i = 0; i < world.smallAsteroids.size(); ++i) {
+            out.entities.push_back(entityOf(world.smallAsteroids[i], ENTITY_SMALL, int32_t(i), world.worldSize));
+        }
+        std::sort(out.entities.begin(), out.entities.end(), [](const EntityState& a, const EntityState& b) { return a.id < b.id; });
+    }
+
+    // STATE packet for state against baseline (null for a full state). sent
+    // gets what was actually written, the baseline to use once the client
+    // acknowledges this tick.
+    static void encode(const GameWorld& world, const Net::WorldState& state, const Net::WorldState* baseline,
+        std::vector<uint8_t>& out, Net::WorldState& sent) {
+        using namespace Net;
+        out.clear();
+        ByteWriter w(out);
+        w.u8(STATE);
+        w.u32(state.tick);
+        w.u32(baseline ? baseline->tick : 0);
+        w.svarint(state.score);
+        w.u16(state.timeLeft);
+        w.u8(state.timesUp);
+
+        w.u8(uint8_t(state.ships.size()));
+        for (const ShipState& s : state.ships) {
+            w.u16(s.x);
+            w.u16(s.y);
+            w.u8(s.rot);
+            w.u8(s.flags);
+        }
+        w.varint(uint32_t(state.bullets.size()));
+        for (const BulletState& b : state.bullets) {
+            w.u16(b.x);
+            w.u16(b.y);
+            w.u8(b.rot);
+        }
+
+        sent.tick = state.tick;
+        sent.score = state.score;
+        sent.timeLeft = state.timeLeft;
+        sent.timesUp = state.timesUp;
+        sent.ships = state.ships;
+        sent.bullets = state.bullets;
+        sent.entities.clear();
+
+        // Walk the state and baseline asteroids together by id
+        static const std::vector<EntityState> none;
+        const std::vector<EntityState>& base = baseline ? baseline->entities : none;
+        std::vector<uint8_t>& changes = scratch(0);
+        std::vector<uint8_t>& removals = scratch(1);
+        ByteWriter cw(changes), rw(removals);
+        uint32_t changeCount = 0, removalCount = 0, lastChanged = 0, lastRemoved = 0;
+        size_t budget = maxPacketSize - out.size() - 16;
+
+        size_t i = 0, j = 0;
+        while (i < state.entities.size() || j < base.size()) {
+            if (j == base.size() || (i < state.entities.size() && state.entities[i].id < base[j].id)) {
+                // New: everything plus the outline, unless the packet is full
+                const EntityState& e = state.entities[i++];
+                size_t corners = e.flags & ENTITY_SMALL ? world.smallAsteroids[e.index].lines.size() : world.asteroids[e.index].lines.size();
+                if (changes.size() + removals.size() + 16 + corners > budget) continue;
+
+                cw.varint(e.id - lastChanged);
+                lastChanged = e.id;
+                cw.u8(FIELD_NEW);
+                cw.u16(e.x);
+                cw.u16(e.y);
+                cw.u8(e.rot);
+                cw.u8(e.flags);
+                if (e.flags & ENTITY_SMALL) writeOutline(cw, world.smallAsteroids[e.index]);
+                else writeOutline(cw, world.asteroids[e.index]);
+                changeCount++;
+                sent.entities.push_back(e);
+            }
+            else if (i == state.entities.size() || base[j].id < state.entities[i].id) {
+                rw.varint(base[j].id - lastRemoved);
+                lastRemoved = base[j].id;
+                removalCount++;
+                j++;
+            }
+            else {
+                const EntityState& e = state.entities[i++];
+                const EntityState& b = base[j++];
+                uint8_t mask = (e.x != b.x ? FIELD_X : 0) | (e.y != b.y ? FIELD_Y : 0) | (e.rot != b.rot ? FIELD_ROT : 0) | (e.flags != b.flags ? FIELD_FLAGS : 0);
+                if (mask) {
+                    cw.varint(e.id - lastChanged);
+                    lastChanged = e.id;
+                    cw.u8(mask);
+                    if (mask & FIELD_X) cw.svarint(int16_t(uint16_t(e.x - b.x)));
+                    if (mask & FIELD_Y) cw.svarint(int16_t(uint16_t(e.y - b.y)));
+                    if (mask & FIELD_ROT) cw.u8(e.rot);
+                    if (mask & FIELD_FLAGS) cw.u8(e.flags);
+                    changeCount++;
+                }
+                sent.entities.push_back(e);
+            }
+        }
+
+        w.varint(changeCount);
+        w.bytes(changes);
+        w.varint(removalCount);
+        w.bytes(removals);
+    }
+
+    // STATE packet into out. findBaseline(tick) returns the client's copy of
+    // an earlier state or null; outlines of new asteroids go into shapes and
+    // removed ones are marked. False if the packet is malformed or its
+    // baseline is gone.
+    template <typename FindBaseline>
+    static bool decode(const uint8_t* data, size_t size, FindBaseline findBaseline, Net::WorldState& out,
+        std::unordered_map<uint32_t, Net::Outline>& shapes) {
+        using namespace Net;
+        ByteReader r(data, size);
+        if (r.u8() != STATE) return false;
+        out.tick = r.u32();
+        uint32_t baseTick = r.u32();
+        const WorldState* baseline = nullptr;
+        if (baseTick != 0) {
+            baseline = findBaseline(baseTick);
+            if (!baseline) return false;
+        }
+        out.score = r.svarint();
+        out.timeLeft = r.u16();
+        out.timesUp = r.u8() != 0;
+
+        uint8_t shipCount = r.u8();
+        if (shipCount > GameWorld::maxShips) return false;     // the client keeps per-ship state for maxShips
+        out.ships.resize(shipCount);
+        for (ShipState& s : out.ships) {
+            s.x = r.u16();
+            s.y = r.u16();
+            s.rot = r.u8();
+            s.flags = r.u8();
+        }
+        uint32_t bulletCount = r.varint();
+        if (bulletCount > r.remaining() / 5) return false;
+        out.bullets.resize(bulletCount);
+        for (BulletState& b : out.bullets) {
+            b.x = r.u16();
+            b.y = r.u16();
+            b.rot = r.u8();
+        }
+
+        // Changes merged into the baseline's asteroids, both in id order
+        static const std::vector<EntityState> none;
+        const std::vector<EntityState>& base = baseline ? baseline->entities : none;
+        out.entities.clear();
+        uint32_t changeCount = r.varint();
+        if (changeCount > r.remaining() / 2) return false;
+        uint32_t id = 0;
+        size_t j = 0;
+        for (uint32_t k = 0; k < changeCount && r.ok; ++k) {
+            id += r.varint();
+            uint8_t mask = r.u8();
+            while (j < base.size() && base[j].id < id) out.entities.push_back(base[j++]);
+            bool inBase = j < base.size() && base[j].id == id;
+
+            EntityState e;
+            if (mask & FIELD_NEW) {
+                e.id = id;
+                e.x = r.u16();
+                e.y = r.u16();
+                e.rot = r.u8();
+                e.flags = r.u8();
+                e.index = -1;
+                uint32_t corners = r.varint();
+                if (corners > r.remaining()) return false;
+                Outline& shape = shapes[id];
+                shape.radii.resize(corners);
+                for (uint8_t& radius : shape.radii) radius = r.u8();
+                shape.removedTick = 0;
+                if (inBase) j++;
+            }
+            else {
+                if (!inBase) return false;
+                e = base[j++];
+                if (mask & FIELD_X) e.x = uint16_t(e.x + r.svarint());
+                if (mask & FIELD_Y) e.y = uint16_t(e.y + r.svarint());
+                if (mask & FIELD_ROT) e.rot = r.u8();
+                if (mask & FIELD_FLAGS) e.flags = r.u8();
+            }
+            out.entities.push_back(e);
+        }
+        while (j < base.size()) out.entities.push_back(base[j++]);
+
+        // Removed ids, also in order
+        uint32_t removalCount = r.varint();
+        if (removalCount > r.remaining()) return false;
+        id = 0;
+        size_t write = 0, read = 0;
+        for (uint32_t k = 0; k < removalCount && r.ok; ++k) {
+            id += r.varint();
+            while (read < out.entities.size() && out.entities[read].id < id) out.entities[write++] = out.entities[read++];
+            if (read < out.entities.size() && out.entities[read].id == id) read++;
+            auto shape = shapes.find(id);
+            if (shape != shapes.end()) shape->second.removedTick = out.tick;
+        }
+        while (read < out.entities.size()) out.entities[write++] = out.entities[read++];
+        out.entities.resize(write);
+
+        // A full state (a new round, or a lost baseline) lists every asteroid
+        // in play; outlines it does not mention are gone
+        if (!baseline) {
+            for (auto& shape : shapes) {
+                if (shape.second.removedTick != 0) continue;
+                auto it = std::lower_bound(out.entities.begin(), out.entities.end(), shape.first,
+                    [](const EntityState& e, uint32_t id) { return e.id < id; });
+                if (it == out.entities.end() || it->id != shape.first) shape.second.removedTick = out.tick;
+            }
+        }
+
+        return r.ok && r.atEnd();
+    }
+
+private:
+    template <typename T>
+    static Net::EntityState entityOf(const T& a, uint8_t flags, int32_t index, const glm::vec2& worldSize) {
+        const glm::vec3& pos = a.exploded ? a.explosionCenter : a.pos;
+        if (a.exploded) flags |= Net::ENTITY_EXPLODING;
+        return { a.id, Net::quantize(pos.x, worldSize.x), Net::quantize(pos.y, worldSize.y), Net::quantizeAngle(a.rot), flags, index };
+    }
+
+    // Outline corners are at even angles, so the distance to each is enough
+    template <typename T>
+    static void writeOutline(Net::ByteWriter& w, const T& a) {
+        w.varint(uint32_t(a.lines.size()));
+        for (const auto& line : a.lines) {
+            w.u8(uint8_t(std::min(255.0f, glm::length(line.first) + 0.5f)));
+        }
+    }
+
+    // Buffers reused between encodes on the same thread
+    static std::vector<uint8_t>& scratch(int which) {
+        thread_local std::vector<uint8_t> buffers[2];
+        buffers[which].clear();
+        return buffers[which];
+    }
+};
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+// Non-blocking UDP socket bound to the loopback interface, for the local
+// multiplayer server and its clients. Datagrams are sent and read whole;
+// receive() returns 0 straight away when nothing is waiting.
+//
+class UdpSocket {
+public:
+    struct Address {
+        uint32_t host = 0;      // network byte order
+        uint16_t port = 0;      // network byte order
+
+        bool operator==(const Address& other) const { return host == other.host && port == other.port; }
+        bool operator!=(const Address& other) const { return !(*this == other); }
+        bool valid() const { return port != 0; }
+    };
+
+    static Address localhost(uint16_t port) {
+        Address address;
+        address.host = htonl(INADDR_LOOPBACK);
+        address.port = htons(port);
+        return address;
+    }
+
+    UdpSocket() {}
+    UdpSocket(const UdpSocket&) = delete;
+    UdpSocket& operator=(const UdpSocket&) = delete;
+
+    ~UdpSocket() {
+        close();
+    }
+
+    // Port 0 lets the system pick a free one
+    bool open(uint16_t port) {
+        close();
+#ifdef _WIN32
+        static bool started = [] {
+            WSADATA data;
+            return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+        }();
+        if (!started) return false;
+#endif
+        handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (handle == invalidHandle) return false;
+
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(port);
+        if (bind(handle, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            close();
+            return false;
+        }
+
+#ifdef _WIN32
+        u_long nonBlocking = 1;
+        bool ok = ioctlsocket(handle, FIONBIO, &nonBlocking) == 0;
+#else
+        bool ok = fcntl(handle, F_SETFL, fcntl(handle, F_GETFL, 0) | O_NONBLOCK) == 0;
+#endif
+        if (!ok) close();
+        return ok;
+    }
+
+    void close() {
+        if (handle == invalidHandle) return;
+#ifdef _WIN32
+        closesocket(handle);
+#else
+        ::close(handle);
+#endif
+        handle = invalidHandle;
+    }
+
+    bool isOpen() const { return handle != invalidHandle; }
+
+    bool send(const Address& to, const void* data, size_t size) {
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = to.host;
+        address.sin_port = to.port;
+        int sent = int(sendto(handle, static_cast<const char*>(data), int(size), 0, reinterpret_cast<sockaddr*>(&address), sizeof(address)));
+        if (sent != int(size)) return false;
+        bytesSent += size;
+        packetsSent++;
+        return true;
+    }
+
+    // Size of the datagram read into data, 0 when none is waiting
+    size_t receive(void* data, size_t capacity, Address& from) {
+        sockaddr_in address = {};
+        socklen_t length = sizeof(address);
+        int received = int(recvfrom(handle, static_cast<char*>(data), int(capacity), 0, reinterpret_cast<sockaddr*>(&address), &length));
+        if (received <= 0) return 0;
+        from.host = address.sin_addr.s_addr;
+        from.port = address.sin_port;
+        bytesReceived += size_t(received);
+        packetsReceived++;
+        return size_t(received);
+    }
+
+    uint64_t bytesSent = 0, bytesReceived = 0;
+    uint64_t packetsSent = 0, packetsReceived = 0;
+
+private:
+#ifdef _WIN32
+    typedef SOCKET Handle;
+    typedef int socklen_t;
+    static constexpr Handle invalidHandle = INVALID_SOCKET;
+#else
+    typedef int Handle;
+    static constexpr Handle invalidHandle = -1;
+#endif
+    Handle handle = invalidHandle;
+};
@@ -2,38 +2,41 @@
 
 #include "ofMain.h"
 #include "Shape.h"
+#include "FastRandom.h"
+#include "RenderQueue.h"
+#include "EffectsGovernor.h"
+#include "TimerWheel.h"
+#include "MemoryTracker.h"
 
 class Player : public Shape {
 public:
-    Player() {
-        pos = glm::vec3(ofGetWidth() / 2, ofGetHeight() / 2, 0);
+    // home is where the player starts and respawns
+    Player(TimerWheel& timers, const glm::vec3& home) : timers(timers), home(home) {
+        pos = home;
         velocity = glm::vec3(0, 0, 0);
         acceleration = glm::vec3(0, 0, 0);
         rot = 0.0f;
         radius = 15.0f;
-        invulnerable = true;  // Player starts as invulnerable
         fadeSpeed = 2.0f;  // Speed of the fading effect
         alpha = 0;  // Start invisible
         fadeDirection = 1;
+        startInvulnerability();  // Player starts as invulnerable
     }
 
-    void update() {
-        float currentTime = ofGetElapsedTimef();
+    ~Player() {
+        timers.cancel(explosionTimer);
+        timers.cancel(invulnerableTimer);
+    }
 
+    void update(const glm::vec2& worldSize) {
+        // The explosion ends from its timer in finishExplosion()
         if (isExploding) {
             updateExplosionParticles();
-
-            if (currentTime - explosionStartTime > explosionDuration) {
-                isExploding = false;
-                invulnerable = true;
-                invulnerableStartTime = currentTime;
-                reset();
-            }
             return;
         }
 
         // Check if invulnerable conditions are done
-        if (invulnerable && (currentTime - invulnerableStartTime > invulnerableDuration) && glm::length(velocity) > 0.1f) {
+        if (invulnerable && invulnerableTimeUp && glm::length(velocity) > 0.1f) {
             invulnerable = false;
         }
 
@@ -51,39 +54,38 @@ public:
         acceleration = glm::vec3(0, 0, 0);
 
         // Screen wrap-around
-        if (pos.x > ofGetWidth()) pos.x = 0;
-        else if (pos.x < 0) pos.x = ofGetWidth();
-        if (pos.y > ofGetHeight()) pos.y = 0;
-        else if (pos.y < 0) pos.y = ofGetHeight();
+        if (pos.x > worldSize.x) pos.x = 0;
+        else if (pos.x < 0) pos.x = worldSize.x;
+        if (pos.y > worldSize.y) pos.y = 0;
+        else if (pos.y < 0) pos.y = worldSize.y;
+        moved();
     }
 
-    void draw() override {
+    // Ship or explosion goes into the frame's render queue
+    void draw(RenderQueue& queue) {
         if (isExploding) {
-            drawExplosionParticles();
+            drawExplosionParticles(queue);
             return;
         }
 
-        ofPushMatrix();
-        ofTranslate(pos.x, pos.y);
-        ofRotateDeg(rot);
-
         // Check whether invulnerable or not
-        if (invulnerable) {
-            ofSetColor(255, 255, 255, alpha);
+        ofColor shipColor = invulnerable ? ofColor(255, 255, 255, alpha) : color;
+
+        // Triangle pointing along rot
+        const glm::vec3 shape[6] = {
+            glm::vec3(-10, 10, 0), glm::vec3(10, 0, 0),
+            glm::vec3(10, 0, 0), glm::vec3(-10, -10, 0),
+            glm::vec3(-10, -10, 0), glm::vec3(-10, 10, 0)
+        };
+        const Transform2D& t = transform();
+        glm::vec3* v = queue.lines(RenderQueue::LAYER_PLAYER, shipColor, 6);
+        for (const glm::vec3& point : shape) {
+            *v++ = t.apply(point);
         }
-        else {
-            ofSetColor(0, 255, 0, 255);
-        }
-
-        ofDrawLine(-10, 10, 10, 0);
-        ofDrawLine(10, 0, -10, -10);
-        ofDrawLine(-10, -10, -10, 10);
-
-        ofPopMatrix();
     }
 
     void applyForce(glm::vec3 force) { acceleration += force; }
-    void rotate(float angle) { rot += angle; }
+    void rotate(float angle) { rot += angle; moved(); }
 
     void thrust(float power) {
         float radians = glm::radians(rot);
@@ -97,16 +99,39 @@ public:
 
     float getRadius() const { return radius; }
 
+    // Farthest an explosion particle gets from the crash (7.1 px/tick damped by 0.95 plus particle radius)
+    static constexpr float explosionReach = 145.0f;
+
+    // Circle around everything draw() puts on screen, the ship or its explosion
+    void getDrawBounds(glm::vec3& center, float& boundsRadius) const {
+        center = isExploding ? explosionCenter : pos;
+        boundsRadius = isExploding ? explosionReach : radius;
+    }
+
+    // Explosion state the world hash covers (WorldHash.h)
+    template <typename Visitor>
+    void visitExplosion(Visitor& v, int index) const {
+        v.field("player", index, "particles", int(explosionParticles.size()));
+        for (const ExplosionParticle& p : explosionParticles) {
+            v.field("player", index, "particle pos", p.pos);
+            v.field("player", index, "particle vel", p.vel);
+            v.field("player", index, "particle lifespan", p.lifespan);
+            v.field("player", index, "particle age", p.age);
+            v.field("player", index, "particle radius", p.radius);
+        }
+    }
+
     void playerHit() {
         if (invulnerable) return;
         triggerExplosion(pos);
     }
 
     void reset() {
-        pos = glm::vec3(ofGetWidth() / 2, ofGetHeight() / 2, 0);
+        pos = home;
         velocity = glm::vec3(0, 0, 0);
         acceleration = glm::vec3(0, 0, 0);
         rot = 0.0f;
+        moved();
     }
 
     float radius;
@@ -114,18 +139,53 @@ public:
     glm::vec3 acceleration;
 
     bool isExploding = false;
-    float explosionStartTime = 0;
     float explosionDuration = 2.0f;
 
     bool invulnerable = false;
-    float invulnerableStartTime = 0;
+    bool invulnerableTimeUp = false;    // set by the timer, cleared once the player moves
     float invulnerableDuration = 1.0f;
 
     float alpha;
     float fadeSpeed;
     int fadeDirection;
 
+    ofColor color = ofColor(0, 255, 0);     // ship and explosion colour, one per ship in multiplayer
+
 private:
+    friend class WorldSnapshot;     // saves the state and re-arms the timers
+
+    TimerWheel& timers;
+    glm::vec3 home;
+    TimerWheel::Handle explosionTimer;
+    TimerWheel::Handle invulnerableTimer;
+
+    void startInvulnerability() {
+        invulnerable = true;
+        invulnerableTimeUp = false;
+        armInvulnerableTimer(TimerWheel::secondsToTicks(invulnerableDuration));
+    }
+
+    void armInvulnerableTimer(uint32_t ticks) {
+        timers.cancel(invulnerableTimer);
+        invulnerableTimer = timers.schedule(ticks, [this] {
+            invulnerableTimeUp = true;
+        });
+    }
+
+    void armExplosionTimer(uint32_t ticks) {
+        timers.cancel(explosionTimer);
+        explosionTimer = timers.schedule(ticks, [this] {
+            finishExplosion();
+        });
+    }
+
+    void finishExplosion() {
+        isExploding = false;
+        explosionParticles.clear();
+        startInvulnerability();
+        reset();
+    }
+
     // Explosion Particle System
     struct ExplosionParticle {
         glm::vec3 pos;
@@ -136,57 +196,71 @@ private:
     };
 
     std::vector<ExplosionParticle> explosionParticles;
+    glm::vec3 explosionCenter;
 
     void triggerExplosion(const glm::vec3& explosionPos) {
+        MemoryScope memoryScope(MemoryTag::PARTICLES);
         isExploding = true;
-        explosionStartTime = ofGetElapsedTimef();
+        explosionCenter = explosionPos;
         explosionParticles.clear();
-
-        for (int i = 0; i < 80; i++) {
+        armExplosionTimer(TimerWheel::secondsToTicks(explosionDuration));
+
+        // Draw every random value for the burst in one batch
+        const int numParticles = 80;
+        float rolls[numParticles * 4];
+        FastRandom& rng = gameRandom();
+        rng.fill(rolls, numParticles * 2, -5, 5);
+        rng.fill(rolls + numParticles * 2, numParticles, 1.0f, 2.0f);
+        rng.fill(rolls + numParticles * 3, numParticles, 1.5f, 3.5f);
+
+        // The whole burst is simulated whatever the effects quality; the
+        // quality only thins out drawExplosionParticles()
+        explosionParticles.reserve(numParticles);
+        for (int i = 0; i < numParticles; i++) {
             ExplosionParticle p;
             p.pos = explosionPos;
-            p.vel = glm::vec3(ofRandom(-5, 5), ofRandom(-5, 5), 0);
-            p.lifespan = ofRandom(1.0f, 2.0f);
+            p.vel = glm::vec3(rolls[i * 2], rolls[i * 2 + 1], 0);
+            p.lifespan = rolls[numParticles * 2 + i];
             p.age = 0;
-            p.radius = ofRandom(1.5f, 3.5f);
+            p.radius = rolls[numParticles * 3 + i];
             explosionParticles.push_back(p);
         }
     }
 
     void updateExplosionParticles() {
         for (auto& p : explosionParticles) {
+            if (p.age > p.lifespan) continue;     // faded, never drawn again
             p.pos += p.vel;
             p.vel *= 0.95f;
             p.age += 1.0f / 60.0f;
         }
-
-        explosionParticles.erase(
-            std::remove_if(explosionParticles.begin(), explosionParticles.end(),
-                [](const ExplosionParticle& p) { return p.age > p.lifespan; }),
-            explosionParticles.end()
-        );
     }
 
-    void drawExplosionParticles() {
-        int segments = 8;
-        for (auto& p : explosionParticles) {
-            float alpha = ofMap(p.age, 0, p.lifespan, 255, 0);
-            ofSetColor(0, 255, 0, alpha);
+    void drawExplosionParticles(RenderQueue& queue) {
+        // Lower effects quality draws the first part of the burst, with
+        // fewer segments, and fades it out sooner
+        const EffectsQuality& quality = effectsQuality();
+        const int segments = quality.ringSegments;  // Number of lines per explosion particle
+        size_t count = std::max<size_t>(1, size_t(explosionParticles.size() * quality.particleScale + 0.5f));
 
-            std::vector<glm::vec3> circlePoints;
-            float angleStep = TWO_PI / segments;
+        for (size_t k = 0; k < count && k < explosionParticles.size(); ++k) {
+            const ExplosionParticle& p = explosionParticles[k];
+            float shown = p.lifespan * quality.lifespanScale;
+            if (p.age > shown) continue;
 
-            for (int i = 0; i < segments; ++i) {
-                float angle = i * angleStep;
-                float x = p.pos.x + cos(angle) * p.radius;
-                float y = p.pos.y + sin(angle) * p.radius;
-                circlePoints.emplace_back(x, y, 0);
-            }
+            float alpha = ofMap(p.age, 0, shown, 255, 0);
+            glm::vec3* v = queue.lines(RenderQueue::LAYER_EXPLOSIONS, ofColor(color, alpha), segments * 2);
 
-            for (int i = 0; i < segments; ++i) {
-                glm::vec3 a = circlePoints[i];
-                glm::vec3 b = circlePoints[(i + 1) % segments];
-                ofDrawLine(a, b);
+            // Ring of segments around the particle
+            float angleStep = TWO_PI / segments;
+            glm::vec3 first(p.pos.x + p.radius, p.pos.y, 0);
+            glm::vec3 last = first;
+            for (int i = 1; i <= segments; ++i) {
+                float angle = i * angleStep;
+                glm::vec3 next = i == segments ? first : glm::vec3(p.pos.x + cos(angle) * p.radius, p.pos.y + sin(angle) * p.radius, 0);
+                *v++ = last;
+                *v++ = next;
+                last = next;
             }
         }
     }
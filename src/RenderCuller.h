@@ -0,0 +1,78 @@
+#pragma once
+
+#include "ofMain.h"
+#include <vector>
+
+// Render culling stage: decides which entities are drawn, and where.
+//
+// Every entity's bounding circle is tested against the view. The world
+// wraps, so a circle that crosses a world edge is also tested at its
+// wrapped positions (shifted by the world width and/or height). Each copy
+// that touches the view becomes a draw item; copies with a non-zero offset
+// are ghosts, which let an asteroid slide across an edge instead of popping
+// from one side to the other.
+//
+class RenderCuller {
+public:
+    enum Kind {
+        PLAYER,
+        ASTEROID,
+        SMALL_ASTEROID
+    };
+
+    struct Item {
+        Kind kind;
+        int index;
+        glm::vec3 offset;       // translation to draw this copy at
+    };
+
+    void begin(const ofRectangle& view, const glm::vec2& worldSize) {
+        this->view = view;
+        this->worldSize = worldSize;
+        items.clear();
+        tested = 0;
+        culled = 0;
+        ghosts = 0;
+    }
+
+    void add(Kind kind, int index, const glm::vec3& center, float radius) {
+        tested++;
+
+        // Shifts that bring a copy across each edge the circle overlaps
+        float offsetsX[2] = { 0, 0 };
+        float offsetsY[2] = { 0, 0 };
+        int countX = 1, countY = 1;
+        if (center.x - radius < 0) offsetsX[countX++] = worldSize.x;
+        else if (center.x + radius > worldSize.x) offsetsX[countX++] = -worldSize.x;
+        if (center.y - radius < 0) offsetsY[countY++] = worldSize.y;
+        else if (center.y + radius > worldSize.y) offsetsY[countY++] = -worldSize.y;
+
+        bool visible = false;
+        for (int y = 0; y < countY; ++y) {
+            for (int x = 0; x < countX; ++x) {
+                glm::vec3 offset(offsetsX[x], offsetsY[y], 0);
+                if (!overlapsView(center + offset, radius)) continue;
+                items.push_back({ kind, index, offset });
+                visible = true;
+                if (x > 0 || y > 0) ghosts++;
+            }
+        }
+        if (!visible) culled++;
+    }
+
+    std::vector<Item> items;
+
+    // Stats for the last frame
+    int tested = 0;
+    int culled = 0;
+    int ghosts = 0;
+
+private:
+    ofRectangle view;
+    glm::vec2 worldSize;
+
+    bool overlapsView(const glm::vec3& p, float radius) const {
+        return p.x + radius >= view.getLeft() && p.x - radius <= view.getRight() &&
+            p.y + radius >= view.getTop() && p.y - radius <= view.getBottom();
+    }
+};
@@ -0,0 +1,188 @@
+#pragma once
+
+#include "ofMain.h"
+#include <vector>
+#include <algorithm>
+
+// Where a RenderQueue's batches end up
+class RenderBackend {
+public:
+    virtual ~RenderBackend() {}
+
+    virtual void setColor(const ofColor& color) = 0;
+
+    // vertices holds count / 2 independent line segments
+    virtual void drawLines(const glm::vec3* vertices, size_t count) = 0;
+};
+
+// Deferred draw commands for one frame.
+//
+// Gameplay code pushes line geometry tagged with a sort key (layer,
+// primitive, colour) instead of drawing it. flush() sorts the commands by
+// key, merges each run with the same key into one batch and hands the
+// batches to a RenderBackend: one colour change per distinct colour and one
+// draw call per batch, instead of a colour change and a draw call per line.
+// Alpha is rounded to 16 steps so fading particles share batches.
+//
+class RenderQueue {
+public:
+    // Drawing order, back to front
+    enum Layer {
+        LAYER_ASTEROIDS,
+        LAYER_EXPLOSIONS,
+        LAYER_BULLETS,
+        LAYER_PLAYER
+    };
+
+    enum Primitive {
+        PRIMITIVE_LINES
+    };
+
+    void begin() {
+        commands.clear();
+        vertices.clear();
+        offset = glm::vec3(0, 0, 0);
+    }
+
+    // Translation added to everything pushed from now on (ghost copies)
+    void setOffset(const glm::vec3& offset) { this->offset = offset; }
+
+    // New line command; returns room for count vertices (count / 2 segments)
+    // in world coordinates, valid until the next call to lines()
+    glm::vec3* lines(Layer layer, const ofColor& color, size_t count) {
+        Command command;
+        command.key = makeKey(layer, PRIMITIVE_LINES, color);
+        command.first = uint32_t(vertices.size());
+        command.count = uint32_t(count);
+        command.offset = offset;
+        commands.push_back(command);
+
+        vertices.resize(vertices.size() + count);
+        return vertices.data() + command.first;
+    }
+
+    // Sort, merge and submit everything pushed since begin()
+    void flush(RenderBackend& backend) {
+        stats = Stats();
+        stats.commands = int(commands.size());
+
+        // Stable so commands with equal keys keep their submission order
+        std::stable_sort(commands.begin(), commands.end(), [](const Command& a, const Command& b) {
+            return a.key < b.key;
+        });
+
+        bool haveColor = false;
+        uint32_t currentColor = 0;
+        for (size_t i = 0; i < commands.size();) {
+            uint64_t key = commands[i].key;
+
+            batch.clear();
+            for (; i < commands.size() && commands[i].key == key; ++i) {
+                const Command& command = commands[i];
+                for (uint32_t v = 0; v < command.count; ++v) {
+                    batch.push_back(vertices[command.first + v] + command.offset);
+                }
+            }
+
+            uint32_t color = uint32_t(key);
+            if (!haveColor || color != currentColor) {
+                backend.setColor(ofColor(color >> 24, (color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF));
+                currentColor = color;
+                haveColor = true;
+                stats.colorChanges++;
+            }
+            backend.drawLines(batch.data(), batch.size());
+            stats.batches++;
+            stats.vertices += int(batch.size());
+        }
+
+        begin();
+    }
+
+    // Counts from the last flush
+    struct Stats {
+        int commands = 0;
+        int batches = 0;
+        int colorChanges = 0;
+        int vertices = 0;
+    };
+    Stats stats;
+
+private:
+    struct Command {
+        uint64_t key;
+        uint32_t first;
+        uint32_t count;
+        glm::vec3 offset;
+    };
+
+    std::vector<Command> commands;
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec3> batch;
+    glm::vec3 offset;
+
+    // layer | primitive | rgba, most significant first
+    static uint64_t makeKey(Layer layer, Primitive primitive, const ofColor& color) {
+        uint32_t alpha = std::min(255u, (uint32_t(color.a) + 8) / 16 * 16);
+        uint32_t rgba = (uint32_t(color.r) << 24) | (uint32_t(color.g) << 16) | (uint32_t(color.b) << 8) | alpha;
+        return (uint64_t(layer) << 40) | (uint64_t(primitive) << 32) | rgba;
+    }
+};
+
+// Draws batches with openFrameworks, one mesh per batch
+class OfRenderBackend : public RenderBackend {
+public:
+    OfRenderBackend() {
+        mesh.setMode(OF_PRIMITIVE_LINES);
+    }
+
+    void setColor(const ofColor& color) override {
+        ofSetColor(color);
+    }
+
+    void drawLines(const glm::vec3* vertices, size_t count) override {
+        mesh.clear();
+        mesh.addVertices(vertices, count);
+        mesh.draw();
+    }
+
+private:
+    ofMesh mesh;
+};
+
+// Records the calls instead of drawing, for checking batching without a GPU
+class RecordingRenderBackend : public RenderBackend {
+public:
+    struct Call {
+        enum Type {
+            SET_COLOR,
+            DRAW_LINES
+        };
+        Type type;
+        ofColor color;
+        size_t vertices;
+    };
+
+    void setColor(const ofColor& color) override {
+        calls.push_back({ Call::SET_COLOR, color, 0 });
+        stateChanges++;
+    }
+
+    void drawLines(const glm::vec3* vertices, size_t count) override {
+        calls.push_back({ Call::DRAW_LINES, ofColor(), count });
+        drawCalls++;
+        this->vertices += count;
+    }
+
+    void reset() {
+        calls.clear();
+        drawCalls = 0;
+        stateChanges = 0;
+        vertices = 0;
+    }
+
+    std::vector<Call> calls;
+    int drawCalls = 0;
+    int stateChanges = 0;
+    size_t vertices = 0;
+};
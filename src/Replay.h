@@ -0,0 +1,237 @@
+#pragma once
+
+#include "SimulationLod.h"
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <fstream>
+
+// Compact binary replay of a gameplay session.
+//
+// Layout (little endian on any host, floats as their IEEE bits):
+//   header  "AARP", uint16 version, uint16 ticks per second,
+//           float width, float height (the screen size the round was
+//           started with, which is the world size outside stress rounds),
+//           uint64 seed,
+//           uint32 stress population (version 2, 0 for a normal round),
+//           uint8 gravity mode (version 3),
+//           uint8 asteroid steering (version 4, 0 random walk, 1 flow field),
+//           float gravity opening angle, float LOD near and far radii,
+//           uint16 LOD mid and far intervals (version 6)
+//   body    runs of (varint tick count, uint8 input bitmask), each run is
+//           one input held for that many ticks; a zero count ends the file
+//
+// Version 5 changed no fields: large asteroids split when the tick's events
+// are applied instead of during the collision pass, so the same inputs play
+// out differently and older recordings are refused. Version 5 files play
+// back with the default opening angle and LOD settings.
+//
+// Inputs only change a few times a second, so a two minute session is a
+// few KB. The recorder streams each run to disk as soon as it ends.
+//
+namespace Replay {
+    static const char magic[4] = { 'A', 'A', 'R', 'P' };
+    static const uint16_t version = 6;
+    static const uint16_t oldestVersion = 5;   // earliest this build reproduces
+
+    struct Header {
+        uint16_t ticksPerSecond = 60;
+        float width = 0;
+        float height = 0;
+        uint64_t seed = 0;
+        uint32_t stressPopulation = 0;
+        uint8_t gravity = 0;
+        uint8_t steering = 0;
+        float theta = 0.6f;
+        float lodNearRadius = 1500.0f;
+        float lodFarRadius = 4000.0f;
+        uint16_t lodMidInterval = 4;
+        uint16_t lodFarInterval = 16;
+    };
+
+    // The LOD settings the recording was made with
+    inline SimLodSettings lodSettings(const Header& header) {
+        SimLodSettings lod;
+        lod.nearRadius = header.lodNearRadius;
+        lod.farRadius = header.lodFarRadius;
+        lod.midInterval = header.lodMidInterval;
+        lod.farInterval = header.lodFarInterval;
+        return lod;
+    }
+}
+
+class ReplayRecorder {
+public:
+    ~ReplayRecorder() {
+        close();
+    }
+
+    bool open(const std::string& path, const Replay::Header& header) {
+        close();
+        file.open(path, std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+
+        file.write(Replay::magic, 4);
+        write(Replay::version);
+        write(header.ticksPerSecond);
+        write(header.width);
+        write(header.height);
+        write(header.seed);
+        write(header.stressPopulation);
+        write(header.gravity);
+        write(header.steering);
+        write(header.theta);
+        write(header.lodNearRadius);
+        write(header.lodFarRadius);
+        write(header.lodMidInterval);
+        write(header.lodFarInterval);
+
+        runLength = 0;
+        return true;
+    }
+
+    // Record the input used for one tick
+    void record(uint8_t input) {
+        if (!file.is_open()) return;
+        if (runLength > 0 && input != runInput) {
+            writeRun();
+        }
+        runInput = input;
+        runLength++;
+    }
+
+    void close() {
+        if (!file.is_open()) return;
+        if (runLength > 0) writeRun();
+        writeVarint(0);
+        file.close();
+    }
+
+    bool isOpen() const { return file.is_open(); }
+
+private:
+    std::ofstream file;
+    uint8_t runInput = 0;
+    uint32_t runLength = 0;
+
+    // Integers low byte first, whatever the host's byte order
+    template <typename T>
+    void write(T value) {
+        for (size_t i = 0; i < sizeof(T); ++i) file.put(char(uint64_t(value) >> (8 * i)));
+    }
+
+    void write(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, 4);
+        write(bits);
+    }
+
+    void writeVarint(uint32_t value) {
+        while (value >= 0x80) {
+            file.put(char((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        file.put(char(value));
+    }
+
+    void writeRun() {
+        writeVarint(runLength);
+        file.put(char(runInput));
+        runLength = 0;
+    }
+};
+
+class ReplayPlayer {
+public:
+    bool open(const std::string& path) {
+        file.open(path, std::ios::binary);
+        if (!file) return false;
+
+        char fileMagic[4];
+        uint16_t fileVersion = 0;
+        file.read(fileMagic, 4);
+        read(fileVersion);
+        if (!file || std::string(fileMagic, 4) != std::string(Replay::magic, 4) || fileVersion < Replay::oldestVersion || fileVersion > Replay::version) {
+            file.close();
+            return false;
+        }
+
+        read(header.ticksPerSecond);
+        read(header.width);
+        read(header.height);
+        read(header.seed);
+        header.stressPopulation = 0;
+        if (fileVersion >= 2) read(header.stressPopulation);
+        header.gravity = 0;
+        if (fileVersion >= 3) read(header.gravity);
+        header.steering = 0;
+        if (fileVersion >= 4) read(header.steering);
+        const Replay::Header defaults;
+        header.theta = defaults.theta;
+        header.lodNearRadius = defaults.lodNearRadius;
+        header.lodFarRadius = defaults.lodFarRadius;
+        header.lodMidInterval = defaults.lodMidInterval;
+        header.lodFarInterval = defaults.lodFarInterval;
+        if (fileVersion >= 6) {
+            read(header.theta);
+            read(header.lodNearRadius);
+            read(header.lodFarRadius);
+            read(header.lodMidInterval);
+            read(header.lodFarInterval);
+        }
+        remaining = 0;
+        finished = !file;
+        return !finished;
+    }
+
+    // Input for the next tick; false once the recording has ended
+    bool next(uint8_t& input) {
+        if (remaining == 0) {
+            if (finished) return false;
+            remaining = readVarint();
+            if (remaining == 0 || !file.get(reinterpret_cast<char&>(runInput))) {
+                finished = true;
+                remaining = 0;
+                return false;
+            }
+        }
+        remaining--;
+        input = runInput;
+        return true;
+    }
+
+    bool isFinished() const { return finished && remaining == 0; }
+
+    Replay::Header header;
+
+private:
+    std::ifstream file;
+    uint8_t runInput = 0;
+    uint32_t remaining = 0;
+    bool finished = true;
+
+    template <typename T>
+    void read(T& value) {
+        uint64_t bits = 0;
+        for (size_t i = 0; i < sizeof(T); ++i) bits |= uint64_t(uint8_t(file.get())) << (8 * i);
+        value = T(bits);
+    }
+
+    void read(float& value) {
+        uint32_t bits;
+        read(bits);
+        std::memcpy(&value, &bits, 4);
+    }
+
+    uint32_t readVarint() {
+        uint32_t value = 0;
+        int shift = 0;
+        char c;
+        while (shift < 35 && file.get(c)) {
+            value |= uint32_t(c & 0x7F) << shift;
+            if (!(c & 0x80)) return value;
+            shift += 7;
+        }
+        return 0;
+    }
+};
@@ -1,10 +1,40 @@
 #pragma once
 
 #include "ofMain.h"
+#include <vector>
 
+// 2D affine transform, the top two rows of translate * rotate * scale:
+// a point (x, y) goes to (a x + b y + tx, c x + d y + ty)
+struct Transform2D {
+	float a = 1, b = 0, tx = 0;
+	float c = 0, d = 1, ty = 0;
+
+	static Transform2D of(const glm::vec3& pos, float rot, const glm::vec3& scale) {
+		float radians = glm::radians(rot);
+		float cs = cos(radians), sn = sin(radians);
+		Transform2D t;
+		t.a = cs * scale.x;
+		t.b = -sn * scale.y;
+		t.c = sn * scale.x;
+		t.d = cs * scale.y;
+		t.tx = pos.x;
+		t.ty = pos.y;
+		return t;
+	}
+
+	glm::vec3 apply(const glm::vec3& p) const {
+		return glm::vec3(tx + (a * p.x + b * p.y), ty + (c * p.x + d * p.y), 0);
+	}
+
+	glm::mat4 toMat4() const {
+		glm::mat4 m(1.0);
+		m[0].x = a; m[1].x = b; m[3].x = tx;     // glm matrices are column-major
+		m[0].y = c; m[1].y = d; m[3].y = ty;
+		return m;
+	}
+};
 
 // Basic Shape class supporting matrix transformations and drawing.
-// 
 //
 class Shape {
 public:
@@ -26,17 +56,29 @@ public:
 		return false;
 	}
 
-	glm::mat4 getTransform() {
-		glm::mat4 T = glm::translate(glm::mat4(1.0), glm::vec3(pos));
-		glm::mat4 R = glm::rotate(glm::mat4(1.0), glm::radians(rot), glm::vec3(0, 0, 1));
-		glm::mat4 S = glm::scale(glm::mat4(1.0), scale);      // added this scale if you want to change size of object
-		return T * R * S;
+	// pos, rot and scale as a 2D affine transform, rebuilt only after
+	// moved() says one of them changed
+	const Transform2D& transform() const {
+		if (transformDirty) {
+			cachedTransform = Transform2D::of(pos, rot, scale);
+			transformDirty = false;
+		}
+		return cachedTransform;
 	}
+
+	// Call after writing pos, rot or scale
+	void moved() { transformDirty = true; }
+
+	glm::mat4 getTransform() const {
+		return transform().toMat4();
+	}
+
 	glm::vec3 pos;
 	float rot = 0.0;    // degrees 
 	glm::vec3 scale = glm::vec3(1, 1, 1);
 	float defaultSize = 20.0;
 
-
-
+private:
+	mutable Transform2D cachedTransform;
+	mutable bool transformDirty = true;
 };
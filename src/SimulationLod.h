@@ -0,0 +1,61 @@
+#pragma once
+
+#include "ofMain.h"
+#include <algorithm>
+
+// Simulation level of detail.
+//
+// Asteroids near the player or inside the camera's view update every tick.
+// Farther out they update every midInterval ticks, and beyond farRadius
+// every farInterval ticks, catching up analytically (position and spin
+// advance by the ticks missed). Asteroids in a reduced band skip
+// asteroid-asteroid bounces. Exploding asteroids always run at full rate
+// so their despawn timing is exact. The default radii cover the whole
+// screen-sized arena, so normal rounds are unaffected; only stress worlds
+// bigger than the screen are thinned out.
+//
+struct SimLodSettings {
+    float nearRadius = 1500.0f;     // full rate inside this distance from the player
+    float farRadius = 4000.0f;      // midInterval out to here, farInterval beyond
+    int midInterval = 4;
+    int farInterval = 16;
+    glm::vec2 viewSize = glm::vec2(0, 0);   // window the camera shows, set by GameWorld::start
+
+    int intervalFor(float distance, bool inView) const {
+        if (inView || distance < nearRadius) return 1;
+        return distance < farRadius ? midInterval : farInterval;
+    }
+};
+
+// Per-entity state, owned by the world's LOD pass
+struct SimLod {
+    int interval = 1;       // ticks between updates in the entity's current band
+    int wait = 1;           // ticks from the last update to the next one
+    int behind = 0;         // ticks since the last update
+
+    bool isFull() const { return interval == 1; }
+};
+
+// Work done and saved in the last tick
+struct SimLodStats {
+    int fullUpdates = 0;        // entities stepped one tick
+    int catchUpUpdates = 0;     // entities stepped several ticks at once
+    int skippedUpdates = 0;     // entities left alone this tick
+    int skippedPairs = 0;       // asteroid-asteroid pairs not resolved because one side is reduced
+};
+
+// Coordinate wrapped into [0, size), keeping how far it went past the edge
+inline float wrapCoordinate(float v, float size) {
+    v = std::fmod(v, size);
+    if (v < 0) v += size;
+    return v < size ? v : 0.0f;
+}
+
+// Distance on the wrapping world
+inline float wrappedDistance(const glm::vec3& a, const glm::vec3& b, const glm::vec2& worldSize) {
+    float dx = std::abs(a.x - b.x);
+    float dy = std::abs(a.y - b.y);
+    dx = std::min(dx, worldSize.x - dx);
+    dy = std::min(dy, worldSize.y - dy);
+    return sqrt(dx * dx + dy * dy);
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "ofMain.h"
+#include "FastRandom.h"
+#include <vector>
+#include <cmath>
+
+// Poisson-disk sampler for asteroid spawn positions.
+//
+// Keeps every new asteroid clear of the player and of all live asteroids,
+// using a uniform grid so each candidate only checks nearby cells. The
+// number of candidates tried is bounded by attempts * (count + obstacles),
+// so a crowded or tiny window returns fewer points instead of looping.
+//
+class SpawnSampler {
+public:
+    // Start a new request over a width x height region
+    void reset(float width, float height, float cellSize) {
+        this->width = width;
+        this->height = height;
+        this->cellSize = std::max(cellSize, 1.0f);
+        cols = std::max(1, int(std::ceil(width / this->cellSize)));
+        rows = std::max(1, int(std::ceil(height / this->cellSize)));
+        cellHead.assign(cols * rows, -1);
+        points.clear();
+        exclusions.clear();
+        maxRadius = 0;
+    }
+
+    // Circle nothing may spawn inside, e.g. the area around the player
+    void addExclusion(const glm::vec3& center, float radius) {
+        exclusions.push_back({ center, radius, -1 });
+    }
+
+    // Existing body that new spawns must not overlap
+    void addObstacle(const glm::vec3& center, float radius) {
+        insert(center, radius);
+    }
+
+    // Add up to count points of the given radius to out, returns how many fit
+    int sample(int count, float radius, std::vector<glm::vec3>& out, int attempts = 30) {
+        if (count <= 0) return 0;
+
+        int produced = 0;
+        FastRandom& rng = gameRandom();
+        candidates.resize(attempts * 2);
+
+        // Uniform darts first so small requests spread over the whole region
+        int dartBudget = count * attempts;
+        while (produced < count && dartBudget > 0) {
+            int batch = std::min(dartBudget, attempts);
+            rng.fill(candidates.data(), batch * 2, 0.0f, 1.0f);
+            for (int i = 0; i < batch && produced < count; ++i) {
+                glm::vec3 p(candidates[i * 2] * width, candidates[i * 2 + 1] * height, 0);
+                if (isFree(p, radius)) {
+                    insert(p, radius);
+                    out.push_back(p);
+                    produced++;
+                }
+            }
+            dartBudget -= batch;
+        }
+
+        // Fill the remaining gaps by growing out from every placed point
+        // (Bridson); a point is retired after one batch of failed attempts
+        activeList.clear();
+        for (int i = 0; i < int(points.size()); ++i) activeList.push_back(i);
+
+        while (produced < count && !activeList.empty()) {
+            int slot = int(rng.next(0.0f, float(activeList.size())));
+            slot = std::min(slot, int(activeList.size()) - 1);
+            const Point origin = points[activeList[slot]];
+            float spacing = origin.radius + radius;
+
+            bool placed = false;
+            rng.fill(candidates.data(), attempts * 2, 0.0f, 1.0f);
+            for (int i = 0; i < attempts; ++i) {
+                float angle = candidates[i * 2] * TWO_PI;
+                float dist = spacing * (1.0f + candidates[i * 2 + 1]);
+                glm::vec3 p = origin.pos + glm::vec3(cos(angle) * dist, sin(angle) * dist, 0);
+                if (isFree(p, radius)) {
+                    activeList.push_back(insert(p, radius));
+                    out.push_back(p);
+                    produced++;
+                    placed = true;
+                    break;
+                }
+            }
+
+            if (!placed) {
+                activeList[slot] = activeList.back();
+                activeList.pop_back();
+            }
+        }
+
+        return produced;
+    }
+
+private:
+    struct Point {
+        glm::vec3 pos;
+        float radius;
+        int next;   // next point in the same grid cell
+    };
+
+    float width = 0, height = 0, cellSize = 1;
+    int cols = 1, rows = 1;
+    float maxRadius = 0;
+
+    std::vector<int> cellHead;
+    std::vector<Point> points;
+    std::vector<Point> exclusions;
+    std::vector<int> activeList;
+    std::vector<float> candidates;
+
+    int cellIndex(float v, float size, int count) const {
+        return std::min(std::max(int(v / size), 0), count - 1);
+    }
+
+    int insert(const glm::vec3& pos, float radius) {
+        int cell = cellIndex(pos.y, cellSize, rows) * cols + cellIndex(pos.x, cellSize, cols);
+        points.push_back({ pos, radius, cellHead[cell] });
+        cellHead[cell] = int(points.size()) - 1;
+        maxRadius = std::max(maxRadius, radius);
+        return cellHead[cell];
+    }
+
+    bool isFree(const glm::vec3& p, float radius) const {
+        if (p.x < 0 || p.x >= width || p.y < 0 || p.y >= height) return false;
+
+        for (const Point& e : exclusions) {
+            if (glm::distance(p, e.pos) < e.radius) return false;
+        }
+
+        // Only cells that can hold an overlapping point need checking
+        int reach = int(std::ceil((maxRadius + radius) / cellSize));
+        int cx = cellIndex(p.x, cellSize, cols);
+        int cy = cellIndex(p.y, cellSize, rows);
+        for (int y = std::max(cy - reach, 0); y <= std::min(cy + reach, rows - 1); ++y) {
+            for (int x = std::max(cx - reach, 0); x <= std::min(cx + reach, cols - 1); ++x) {
+                for (int i = cellHead[y * cols + x]; i != -1; i = points[i].next) {
+                    float minDist = points[i].radius + radius;
+                    glm::vec3 d = points[i].pos - p;
+                    if (d.x * d.x + d.y * d.y < minDist * minDist) return false;
+                }
+            }
+        }
+        return true;
+    }
+};
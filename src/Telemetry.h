@@ -0,0 +1,295 @@
+#pragma once
+
+#include "GameWorld.h"
+#include "MemoryTracker.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Session telemetry: fixed-size binary records of frame timings, entity
+// counts, gameplay events and end-of-round stats.
+//
+// The game thread copies each record into a single-producer,
+// single-consumer ring and never waits: when the ring is full the record is
+// dropped and counted. A background thread drains the ring every few
+// milliseconds into <prefix>-<n>.tlm, starting a new file every
+// maxFileBytes and deleting all but the newest maxFiles. TelemetryReader
+// turns the files back into CSV.
+//
+// File layout (host byte order): "AATL", uint16 version, uint16 record
+// size, uint32 byte order mark, then records back to back. Records are
+// written as they sit in the ring, so nothing is converted on the writer
+// thread; the reader refuses files whose mark shows the other byte order.
+// Record fields by type:
+//   FRAME  values: update ms, draw ms, frame ms, render scale
+//          counts: asteroids, small asteroids, bullets, render commands, events, ships
+//   EVENT  detail: GameEvent type; values: x, y; counts: size, count
+//   ROUND  extra: seed; values: seconds played, world width, world height
+//          counts: score, deaths, asteroids destroyed, ticks
+//
+namespace Telemetry {
+    static const char magic[4] = { 'A', 'A', 'T', 'L' };
+    static const uint16_t version = 2;
+    static const uint32_t byteOrderMark = 0x01020304;
+
+    enum RecordType : uint16_t { FRAME = 1, EVENT, ROUND };
+
+    // One cache line
+    struct Record {
+        uint16_t type;
+        uint16_t detail;
+        uint32_t tick;
+        uint64_t timeNs;            // since the logger started
+        uint64_t extra;
+        float values[4];
+        int32_t counts[6];
+    };
+    static_assert(sizeof(Record) == 64, "telemetry records are one cache line");
+
+    // Lock-free ring for one producer thread and one consumer thread;
+    // Capacity must be a power of two
+    template <typename T, size_t Capacity>
+    class SpscRing {
+    public:
+        static_assert((Capacity & (Capacity - 1)) == 0, "ring capacity must be a power of two");
+
+        // Producer: false, with nothing written, when the ring is full
+        bool push(const T& item) {
+            size_t h = head.load(std::memory_order_relaxed);
+            if (h - cachedTail == Capacity) {
+                cachedTail = tail.load(std::memory_order_acquire);
+                if (h - cachedTail == Capacity) return false;
+            }
+            slots[h & (Capacity - 1)] = item;
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer: up to max items into out, oldest first
+        size_t pop(T* out, size_t max) {
+            size_t t = tail.load(std::memory_order_relaxed);
+            size_t available = head.load(std::memory_order_acquire) - t;
+            size_t n = std::min(available, max);
+            for (size_t i = 0; i < n; ++i) out[i] = slots[(t + i) & (Capacity - 1)];
+            tail.store(t + n, std::memory_order_release);
+            return n;
+        }
+
+    private:
+        // Producer and consumer indices on separate cache lines
+        alignas(64) std::atomic<size_t> head{ 0 };
+        size_t cachedTail = 0;      // producer's last look at tail
+        alignas(64) std::atomic<size_t> tail{ 0 };
+        alignas(64) T slots[Capacity];
+    };
+}
+
+class TelemetryLogger {
+public:
+    size_t maxFileBytes = 4 << 20;
+    int maxFiles = 8;
+
+    ~TelemetryLogger() {
+        stop();
+    }
+
+    // Writes <prefix>-0000.tlm onwards; the directory must exist
+    bool start(const std::string& prefix) {
+        MemoryScope memoryScope(MemoryTag::TELEMETRY);
+        stop();
+        this->prefix = prefix;
+        fileIndex = 0;
+        if (!openFile()) return false;
+        ring.reset(new Ring());
+        dropped = 0;
+        recordsWritten = 0;
+        epoch = std::chrono::steady_clock::now();
+        running = true;
+        writer = std::thread([this] { drainLoop(); });
+        return true;
+    }
+
+    // Writes out everything still in the ring
+    void stop() {
+        if (!writer.joinable()) return;
+        running = false;
+        writer.join();
+        file.close();
+    }
+
+    bool isRunning() const { return writer.joinable(); }
+
+    // Game thread: one record, dropped if the writer has fallen behind
+    void push(const Telemetry::Record& record) {
+        if (!ring || !ring->push(record)) dropped++;
+    }
+
+    // Frame timings and entity counts after a frame's update
+    void recordFrame(const GameWorld& world, float updateMs, float drawMs, float frameMs, float renderScale) {
+        Telemetry::Record r = record(Telemetry::FRAME, world.tick);
+        r.values[0] = updateMs;
+        r.values[1] = drawMs;
+        r.values[2] = frameMs;
+        r.values[3] = renderScale;
+        r.counts[0] = int32_t(world.asteroids.size());
+        r.counts[1] = int32_t(world.smallAsteroids.size());
+        r.counts[2] = int32_t(world.bullets.size());
+        r.counts[3] = world.renderQueue.stats.commands;
+        r.counts[4] = int32_t(world.events.size());
+        r.counts[5] = world.numShips();
+        push(r);
+    }
+
+    // The last tick's events, all with the same timestamp
+    void recordEvents(const GameWorld& world) {
+        if (world.events.empty()) return;
+        Telemetry::Record r = record(Telemetry::EVENT, world.tick);
+        for (const GameEvent& e : world.events) {
+            r.detail = uint16_t(e.type);
+            r.values[0] = e.pos.x;
+            r.values[1] = e.pos.y;
+            r.counts[0] = int32_t(e.size);
+            r.counts[1] = e.count;
+            push(r);
+        }
+    }
+
+    // Final stats of a round, the ones the end screen shows
+    void recordRound(const GameWorld& world) {
+        Telemetry::Record r = record(Telemetry::ROUND, world.tick);
+        r.extra = world.seed;
+        r.values[0] = float(world.tick) / TimerWheel::ticksPerSecond;
+        r.values[1] = world.worldSize.x;
+        r.values[2] = world.worldSize.y;
+        r.counts[0] = world.score;
+        r.counts[1] = world.playerDeaths;
+        r.counts[2] = world.asteroidsDestroyed;
+        r.counts[3] = int32_t(world.tick);
+        push(r);
+    }
+
+    uint64_t dropped = 0;                       // game thread's count of records the ring had no room for
+    std::atomic<uint64_t> recordsWritten{ 0 };
+
+private:
+    typedef Telemetry::SpscRing<Telemetry::Record, 8192> Ring;
+
+    std::unique_ptr<Ring> ring;
+    std::thread writer;
+    std::atomic<bool> running{ false };
+    std::chrono::steady_clock::time_point epoch;
+    std::string prefix;
+    std::ofstream file;
+    size_t fileBytes = 0;
+    int fileIndex = 0;
+
+    Telemetry::Record record(Telemetry::RecordType type, uint32_t tick) const {
+        Telemetry::Record r = {};
+        r.type = type;
+        r.tick = tick;
+        r.timeNs = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+        return r;
+    }
+
+    std::string pathFor(int index) const {
+        char suffix[16];
+        snprintf(suffix, sizeof(suffix), "-%04d.tlm", index);
+        return prefix + suffix;
+    }
+
+    bool openFile() {
+        file.close();
+        file.open(pathFor(fileIndex), std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+        uint16_t header[2] = { Telemetry::version, uint16_t(sizeof(Telemetry::Record)) };
+        file.write(Telemetry::magic, 4);
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(&Telemetry::byteOrderMark), sizeof(Telemetry::byteOrderMark));
+        fileBytes = 12;
+        if (fileIndex >= maxFiles) std::remove(pathFor(fileIndex - maxFiles).c_str());
+        return true;
+    }
+
+    // Writer thread: drain, write, rotate; sleeps while the ring is empty
+    void drainLoop() {
+        MemoryScope memoryScope(MemoryTag::TELEMETRY);
+        std::vector<Telemetry::Record> batch(1024);
+        for (;;) {
+            bool stopping = !running;
+            size_t n = ring->pop(batch.data(), batch.size());
+            if (n > 0) {
+                if (fileBytes + n * sizeof(Telemetry::Record) > maxFileBytes) {
+                    fileIndex++;
+                    openFile();
+                }
+                file.write(reinterpret_cast<const char*>(batch.data()), std::streamsize(n * sizeof(Telemetry::Record)));
+                fileBytes += n * sizeof(Telemetry::Record);
+                recordsWritten += n;
+            }
+            else if (stopping) {
+                break;
+            }
+            else {
+                file.flush();
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+        }
+    }
+};
+
+// Telemetry files to CSV: <out>-frames.csv, <out>-events.csv and <out>-rounds.csv
+class TelemetryReader {
+public:
+    // Files in the order they were written; false if one is not a telemetry file
+    static bool toCsv(const std::vector<std::string>& paths, const std::string& out, size_t& records) {
+        std::ofstream frames(out + "-frames.csv"), events(out + "-events.csv"), rounds(out + "-rounds.csv");
+        if (!frames || !events || !rounds) return false;
+        frames << "tick,time_ms,update_ms,draw_ms,frame_ms,render_scale,asteroids,small_asteroids,bullets,render_commands,events,ships\n";
+        events << "tick,time_ms,event,x,y,size,count\n";
+        rounds << "tick,time_ms,seed,seconds,width,height,score,deaths,asteroids_destroyed,ticks\n";
+
+        static const char* eventNames[] = { "asteroid_hit", "asteroid_split", "player_death", "spawn_request", "shot" };
+        records = 0;
+        for (const std::string& path : paths) {
+            std::ifstream file(path, std::ios::binary);
+            char fileMagic[4];
+            uint16_t header[2] = {};
+            uint32_t byteOrder = 0;
+            file.read(fileMagic, 4);
+            file.read(reinterpret_cast<char*>(header), sizeof(header));
+            file.read(reinterpret_cast<char*>(&byteOrder), sizeof(byteOrder));
+            if (!file || std::string(fileMagic, 4) != std::string(Telemetry::magic, 4) || header[0] != Telemetry::version
+                || header[1] != sizeof(Telemetry::Record) || byteOrder != Telemetry::byteOrderMark) {
+                return false;
+            }
+
+            Telemetry::Record r;
+            while (file.read(reinterpret_cast<char*>(&r), sizeof(r))) {
+                records++;
+                double ms = r.timeNs / 1e6;
+                if (r.type == Telemetry::FRAME) {
+                    frames << r.tick << ',' << ms << ',' << r.values[0] << ',' << r.values[1] << ',' << r.values[2] << ',' << r.values[3];
+                    for (int32_t count : r.counts) frames << ',' << count;
+                    frames << '\n';
+                }
+                else if (r.type == Telemetry::EVENT) {
+                    const char* name = r.detail < 5 ? eventNames[r.detail] : "unknown";
+                    events << r.tick << ',' << ms << ',' << name << ',' << r.values[0] << ',' << r.values[1] << ','
+                        << (r.counts[0] == GameEvent::LARGE ? "large" : "small") << ',' << r.counts[1] << '\n';
+                }
+                else if (r.type == Telemetry::ROUND) {
+                    rounds << r.tick << ',' << ms << ',' << r.extra << ',' << r.values[0] << ',' << r.values[1] << ',' << r.values[2];
+                    for (int i = 0; i < 4; ++i) rounds << ',' << r.counts[i];
+                    rounds << '\n';
+                }
+            }
+        }
+        return true;
+    }
+};
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <functional>
+
+// Hierarchical timer wheel driving the gameplay timers (player explosion,
+// invulnerability, fire cooldown, round timer, asteroid despawns).
+//
+// Time is counted in simulation ticks, one per ofApp::update during play.
+// Four levels of 64 slots cover about three days of ticks. Scheduling and
+// cancelling are O(1), and each advance() only touches the timers that
+// expire on that tick, plus a cascade of one slot every 64 ticks.
+//
+class TimerWheel {
+public:
+    using Callback = std::function<void()>;
+
+    static constexpr int ticksPerSecond = 60;
+
+    static uint32_t secondsToTicks(float seconds) {
+        return uint32_t(std::ceil(seconds * ticksPerSecond));
+    }
+
+    // Identifies a scheduled timer; stale handles are ignored by cancel()
+    struct Handle {
+        int index = -1;
+        uint32_t generation = 0;
+    };
+
+    TimerWheel() {
+        clear();
+    }
+
+    // Run callback after delayTicks ticks (at least one)
+    Handle schedule(uint32_t delayTicks, Callback callback) {
+        int index;
+        if (!freeList.empty()) {
+            index = freeList.back();
+            freeList.pop_back();
+        }
+        else {
+            index = int(nodes.size());
+            nodes.emplace_back();
+        }
+
+        Node& node = nodes[index];
+        node.expires = currentTick + std::max(delayTicks, 1u);
+        node.callback = std::move(callback);
+        node.pending = true;
+        place(index);
+
+        Handle handle;
+        handle.index = index;
+        handle.generation = node.generation;
+        return handle;
+    }
+
+    // Cancel a pending timer and invalidate the handle
+    bool cancel(Handle& handle) {
+        bool wasPending = isPending(handle);
+        if (wasPending) {
+            unlink(handle.index);
+            release(handle.index);
+        }
+        handle = Handle();
+        return wasPending;
+    }
+
+    bool isPending(const Handle& handle) const {
+        return handle.index >= 0 && handle.index < int(nodes.size())
+            && nodes[handle.index].pending && nodes[handle.index].generation == handle.generation;
+    }
+
+    uint32_t ticksRemaining(const Handle& handle) const {
+        return isPending(handle) ? nodes[handle.index].expires - currentTick : 0;
+    }
+
+    // Step one tick and fire every timer that expires on it
+    void advance() {
+        currentTick++;
+
+        // Pull the next block of timers down a level whenever a level wraps
+        for (int level = 1; level < numLevels; ++level) {
+            if ((currentTick & ((1u << (levelBits * level)) - 1)) != 0) break;
+            cascade(level, (currentTick >> (levelBits * level)) & slotMask);
+        }
+
+        // Move the due slot to the firing list, so callbacks may freely
+        // schedule or cancel other timers while it is being drained
+        int& due = heads[currentTick & slotMask];
+        heads[firingList] = due;
+        for (int i = due; i != -1; i = nodes[i].next) nodes[i].slot = firingList;
+        due = -1;
+
+        while (heads[firingList] != -1) {
+            int index = heads[firingList];
+            unlink(index);
+            Callback callback = std::move(nodes[index].callback);
+            release(index);
+            callback();
+        }
+    }
+
+    // Drop every pending timer, e.g. when a new game starts
+    void clear() {
+        for (int& head : heads) head = -1;
+        freeList.clear();
+        for (int i = int(nodes.size()) - 1; i >= 0; --i) {
+            if (nodes[i].pending) {
+                nodes[i].pending = false;
+                nodes[i].generation++;
+                nodes[i].callback = nullptr;
+            }
+            freeList.push_back(i);
+        }
+    }
+
+    uint32_t now() const { return currentTick; }
+
+    size_t pendingCount() const { return nodes.size() - freeList.size(); }
+
+private:
+    static constexpr int levelBits = 6;
+    static constexpr int slotsPerLevel = 1 << levelBits;
+    static constexpr uint32_t slotMask = slotsPerLevel - 1;
+    static constexpr int numLevels = 4;
+    static constexpr int firingList = numLevels * slotsPerLevel;
+
+    struct Node {
+        uint32_t expires = 0;
+        Callback callback;
+        int prev = -1, next = -1;
+        int slot = -1;
+        uint32_t generation = 1;
+        bool pending = false;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<int> freeList;
+    int heads[numLevels * slotsPerLevel + 1];
+    uint32_t currentTick = 0;
+
+    // Put a node in the slot matching how far away its expiry is
+    void place(int index) {
+        Node& node = nodes[index];
+        uint32_t delta = node.expires - currentTick;
+        int level = 0;
+        while (level < numLevels - 1 && delta >= (1u << (levelBits * (level + 1)))) level++;
+        if (level == numLevels - 1 && delta >= (1u << (levelBits * numLevels))) {
+            node.expires = currentTick + (1u << (levelBits * numLevels)) - 1;
+        }
+
+        int slot = level * slotsPerLevel + int((node.expires >> (levelBits * level)) & slotMask);
+        node.slot = slot;
+        node.prev = -1;
+        node.next = heads[slot];
+        if (node.next != -1) nodes[node.next].prev = index;
+        heads[slot] = index;
+    }
+
+    void unlink(int index) {
+        Node& node = nodes[index];
+        if (node.prev != -1) nodes[node.prev].next = node.next;
+        else heads[node.slot] = node.next;
+        if (node.next != -1) nodes[node.next].prev = node.prev;
+        node.prev = node.next = -1;
+    }
+
+    void release(int index) {
+        Node& node = nodes[index];
+        node.pending = false;
+        node.generation++;
+        node.callback = nullptr;
+        freeList.push_back(index);
+    }
+
+    void cascade(int level, uint32_t slotIndex) {
+        int& head = heads[level * slotsPerLevel + slotIndex];
+        int index = head;
+        head = -1;
+        while (index != -1) {
+            int next = nodes[index].next;
+            place(index);
+            index = next;
+        }
+    }
+};
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "GameWorld.h"
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sstream>
+
+// World-state checksums for checking optimized code against the reference.
+//
+// visitWorldState walks the simulation state in a fixed order (world
+// counters, ships, bullets, large asteroids, small asteroids), explosion
+// particles included; they are spawned in full at every effects quality,
+// so the hash only depends on the seed and the inputs. hashWorld folds it
+// into a 64-bit FNV-1a hash, and findDivergence walks two worlds side by
+// side to name the first entity and field that differ.
+//
+template <typename Visitor>
+void visitWorldState(const GameWorld& world, Visitor& v) {
+    v.field("world", 0, "tick", int(world.tick));
+    v.field("world", 0, "score", world.score);
+    v.field("world", 0, "playerDeaths", world.playerDeaths);
+    v.field("world", 0, "asteroidsDestroyed", world.asteroidsDestroyed);
+    v.field("world", 0, "timesUp", int(world.timesUp));
+    v.field("world", 0, "canFire", int(world.canFire));
+    v.field("world", 0, "bullets", int(world.bullets.size()));
+    v.field("world", 0, "asteroids", int(world.asteroids.size()));
+    v.field("world", 0, "smallAsteroids", int(world.smallAsteroids.size()));
+
+    // Ships past the first only exist in multiplayer, so single-player hashes are unchanged
+    for (int i = 0; i < world.numShips(); ++i) {
+        const Player& player = world.ship(i);
+        v.field("player", i, "pos", player.pos);
+        v.field("player", i, "velocity", player.velocity);
+        v.field("player", i, "rot", player.rot);
+        v.field("player", i, "isExploding", int(player.isExploding));
+        v.field("player", i, "invulnerable", int(player.invulnerable));
+        player.visitExplosion(v, i);
+    }
+
+    for (size_t i = 0; i < world.bullets.size(); ++i) {
+        v.field("bullet", int(i), "pos", world.bullets.position(i));
+        v.field("bullet", int(i), "velocity", world.bullets.velocity(i));
+    }
+
+    for (size_t i = 0; i < world.asteroids.size(); ++i) {
+        const Asteroid& asteroid = world.asteroids[i];
+        v.field("asteroid", int(i), "pos", asteroid.getPosition());
+        v.field("asteroid", int(i), "velocity", asteroid.getVelocity());
+        v.field("asteroid", int(i), "isExploding", int(asteroid.isExploding()));
+        v.field("asteroid", int(i), "hasBeenHit", int(asteroid.hasBeenHit));
+        asteroid.visitState(v, "asteroid", int(i));
+    }
+
+    for (size_t i = 0; i < world.smallAsteroids.size(); ++i) {
+        const SmallAsteroid& smallAsteroid = world.smallAsteroids[i];
+        v.field("smallAsteroid", int(i), "pos", smallAsteroid.getPosition());
+        v.field("smallAsteroid", int(i), "velocity", smallAsteroid.getVelocity());
+        v.field("smallAsteroid", int(i), "isExploding", int(smallAsteroid.isExploding()));
+        v.field("smallAsteroid", int(i), "hasBeenHit", int(smallAsteroid.hasBeenHit));
+        smallAsteroid.visitState(v, "smallAsteroid", int(i));
+    }
+}
+
+// 64-bit FNV-1a over the raw bits of each field
+class WorldHasher {
+public:
+    template <typename T>
+    void field(const char*, int, const char*, const T& value) {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            hash ^= bytes[i];
+            hash *= 0x100000001B3ULL;
+        }
+    }
+
+    void field(const char* entity, int index, const char* name, const glm::vec3& value) {
+        field(entity, index, name, value.x);
+        field(entity, index, name, value.y);
+        field(entity, index, name, value.z);
+    }
+
+    uint64_t hash = 0xCBF29CE484222325ULL;
+};
+
+inline uint64_t hashWorld(const GameWorld& world) {
+    WorldHasher hasher;
+    visitWorldState(world, hasher);
+    return hasher.hash;
+}
+
+// Flattened copy of a world's state, only built when hashes disagree
+class WorldStateDump {
+public:
+    struct Entry {
+        std::string label;
+        glm::vec3 value;
+    };
+
+    void field(const char* entity, int index, const char* name, int value) {
+        add(entity, index, name, glm::vec3(float(value), 0, 0));
+    }
+
+    void field(const char* entity, int index, const char* name, float value) {
+        add(entity, index, name, glm::vec3(value, 0, 0));
+    }
+
+    void field(const char* entity, int index, const char* name, const glm::vec3& value) {
+        add(entity, index, name, value);
+    }
+
+    std::vector<Entry> entries;
+
+private:
+    void add(const char* entity, int index, const char* name, const glm::vec3& value) {
+        std::ostringstream label;
+        label << entity << " " << index << " " << name;
+        entries.push_back({ label.str(), value });
+    }
+};
+
+// First field that differs between two worlds, or "" when they match
+inline std::string findDivergence(const GameWorld& a, const GameWorld& b) {
+    WorldStateDump dumpA, dumpB;
+    visitWorldState(a, dumpA);
+    visitWorldState(b, dumpB);
+
+    size_t count = std::min(dumpA.entries.size(), dumpB.entries.size());
+    for (size_t i = 0; i < count; ++i) {
+        const WorldStateDump::Entry& ea = dumpA.entries[i];
+        const WorldStateDump::Entry& eb = dumpB.entries[i];
+        if (ea.label != eb.label || std::memcmp(&ea.value, &eb.value, sizeof(glm::vec3)) != 0) {
+            std::ostringstream out;
+            out.precision(9);
+            out << ea.label << ": (" << ea.value.x << ", " << ea.value.y << ", " << ea.value.z << ")"
+                << " vs " << eb.label << ": (" << eb.value.x << ", " << eb.value.y << ", " << eb.value.z << ")";
+            return out.str();
+        }
+    }
+    if (dumpA.entries.size() != dumpB.entries.size()) {
+        return "entity counts differ";
+    }
+    return "";
+}
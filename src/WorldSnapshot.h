@@ -0,0 +1,529 @@
+#pragma once
+
+#include "GameWorld.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Flat binary checkpoint of a whole world, for instant retries, debugging
+// captures and benchmark fixtures.
+//
+// Layout (host byte order, every section 8-byte aligned):
+//   header    "AAWS", uint32 version, uint32 total size, uint32 byte order
+//             mark, then the offset and record count of each section
+//   sections  world, ships, bullets, asteroids, small asteroids, outline
+//             points, explosion particles, gravity wells, despawn timers
+//
+// The ship section holds one record per ship, the local player's first.
+// Records are plain structs read in place, so a file loaded into memory
+// (or mapped) is used without parsing. Nothing is byte-swapped: a file
+// saved on a machine of the other byte order fails the byte order check
+// and is refused. The world record keeps the settings the simulation
+// depends on (LOD, gravity opening angle, flow strength) along with the
+// counters. Asteroids point at their outline and explosion particles by
+// offset and count into the shared sections.
+// Pending timers are stored as ticks remaining and re-armed on restore;
+// the random stream is stored raw, so a restored world continues exactly
+// as the saved one would have.
+//
+namespace Snapshot {
+    static const char magic[4] = { 'A', 'A', 'W', 'S' };
+    static const uint32_t version = 4;
+    static const uint32_t byteOrderMark = 0x01020304;
+
+    enum SectionId {
+        WORLD, PLAYER, BULLETS, ASTEROIDS, SMALL_ASTEROIDS, OUTLINES, PARTICLES, WELLS, DESPAWNS,
+        NUM_SECTIONS
+    };
+
+    struct Section {
+        uint32_t offset;
+        uint32_t count;
+    };
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t size;
+        uint32_t byteOrder;             // byteOrderMark as written by the saving machine
+        Section sections[NUM_SECTIONS];
+    };
+
+    struct Vec3 {
+        float x, y, z;
+    };
+
+    struct WorldRecord {
+        uint64_t seed;
+        uint32_t tick;
+        float width, height;
+        int32_t score, playerDeaths, asteroidsDestroyed;
+        float timer;
+        uint32_t roundTimerTicks;       // 0 when no timer is pending
+        uint32_t fireTimerTicks;
+        int32_t stressPopulation;
+        float roundLength, fireRate;
+        int32_t minAsteroids, baseSides, destroyedPerSide;
+        uint8_t timesUp, canFire, gravity, steering;
+        uint32_t nextEntityId, pad;
+        float theta, flowStrength;
+        float lodNearRadius, lodFarRadius;
+        int32_t lodMidInterval, lodFarInterval;
+        float lodViewWidth, lodViewHeight;
+        FastRandom::State rng;
+    };
+
+    struct ParticleRecord {
+        Vec3 pos, vel;
+        float lifespan, age, radius;
+    };
+
+    struct PlayerRecord {
+        Vec3 home, pos, velocity, acceleration, explosionCenter;
+        float rot, alpha;
+        int32_t fadeDirection;
+        uint8_t isExploding, invulnerable, invulnerableTimeUp, canFire;   // canFire unused for ship 0, see WorldRecord
+        uint32_t explosionTimerTicks, invulnerableTimerTicks;
+        uint32_t fireTimerTicks;
+        uint32_t pad;
+        uint32_t particleOffset, particleCount;
+    };
+
+    struct BulletRecord {
+        Vec3 pos, velocity;
+        float rot;
+        uint32_t age;                   // ticks since it was fired
+    };
+
+    // Large and small asteroids share the record
+    struct AsteroidRecord {
+        Vec3 pos, velocity, acceleration, explosionCenter;
+        float rot, rotationSpeed, minRadius, maxRadius;
+        float explosionAge, explosionLifetime;
+        int32_t numSides;
+        uint32_t outlineOffset, outlineCount;
+        uint32_t particleOffset, particleCount;
+        int32_t lodInterval, lodWait, lodBehind;
+        uint32_t id;
+        uint8_t exploded, hasBeenHit, pad[2];
+    };
+
+    struct WellRecord {
+        Vec3 pos;
+        float mass;
+    };
+}
+
+class WorldSnapshot {
+public:
+    // Whole world into out, replacing its contents
+    static void capture(const GameWorld& world, std::vector<char>& out) {
+        using namespace Snapshot;
+
+        // Count every section first so the buffer is sized once
+        uint32_t counts[NUM_SECTIONS] = {};
+        counts[WORLD] = 1;
+        counts[PLAYER] = uint32_t(world.numShips());
+        counts[BULLETS] = uint32_t(world.bullets.size());
+        counts[ASTEROIDS] = uint32_t(world.asteroids.size());
+        counts[SMALL_ASTEROIDS] = uint32_t(world.smallAsteroids.size());
+        for (int i = 0; i < world.numShips(); ++i) {
+            counts[PARTICLES] += uint32_t(world.ship(i).explosionParticles.size());
+        }
+        for (const Asteroid& a : world.asteroids) {
+            counts[OUTLINES] += uint32_t(a.lines.size());
+            counts[PARTICLES] += uint32_t(a.explosionParticles.size());
+        }
+        for (const SmallAsteroid& a : world.smallAsteroids) {
+            counts[OUTLINES] += uint32_t(a.lines.size());
+            counts[PARTICLES] += uint32_t(a.explosionParticles.size());
+        }
+        counts[WELLS] = uint32_t(world.wells.size());
+        for (const TimerWheel::Handle& h : world.despawnTimers) {
+            if (world.timers.isPending(h)) counts[DESPAWNS]++;
+        }
+
+        static const size_t recordSizes[NUM_SECTIONS] = {
+            sizeof(WorldRecord), sizeof(PlayerRecord), sizeof(BulletRecord), sizeof(AsteroidRecord), sizeof(AsteroidRecord),
+            sizeof(Vec3), sizeof(ParticleRecord), sizeof(WellRecord), sizeof(uint32_t)
+        };
+
+        Header header;
+        std::memcpy(header.magic, magic, 4);
+        header.version = version;
+        header.byteOrder = byteOrderMark;
+        size_t size = align(sizeof(Header));
+        for (int i = 0; i < NUM_SECTIONS; ++i) {
+            header.sections[i].offset = uint32_t(size);
+            header.sections[i].count = counts[i];
+            size += align(recordSizes[i] * counts[i]);
+        }
+        header.size = uint32_t(size);
+
+        out.assign(size, 0);
+        char* base = out.data();
+        std::memcpy(base, &header, sizeof(Header));
+
+        // World counters, settings and pending world timers
+        WorldRecord& w = *section<WorldRecord>(base, header, WORLD);
+        w.seed = world.seed;
+        w.tick = world.tick;
+        w.width = world.worldSize.x;
+        w.height = world.worldSize.y;
+        w.score = world.score;
+        w.playerDeaths = world.playerDeaths;
+        w.asteroidsDestroyed = world.asteroidsDestroyed;
+        w.timer = world.timer;
+        w.roundTimerTicks = world.timers.ticksRemaining(world.roundTimer);
+        w.fireTimerTicks = world.timers.ticksRemaining(world.fireTimer);
+        w.stressPopulation = world.stressPopulation;
+        w.roundLength = world.roundLength;
+        w.fireRate = world.fireRate;
+        w.minAsteroids = world.minAsteroids;
+        w.baseSides = world.baseSides;
+        w.destroyedPerSide = world.destroyedPerSide;
+        w.timesUp = world.timesUp;
+        w.canFire = world.canFire;
+        w.gravity = world.gravity;
+        w.steering = uint8_t(world.steering);
+        w.nextEntityId = world.nextEntityId;
+        w.theta = world.gravityField.theta;
+        w.flowStrength = world.flowStrength;
+        w.lodNearRadius = world.lodSettings.nearRadius;
+        w.lodFarRadius = world.lodSettings.farRadius;
+        w.lodMidInterval = world.lodSettings.midInterval;
+        w.lodFarInterval = world.lodSettings.farInterval;
+        w.lodViewWidth = world.lodSettings.viewSize.x;
+        w.lodViewHeight = world.lodSettings.viewSize.y;
+        w.rng = world.rng.getState();
+
+        ParticleRecord* particles = section<ParticleRecord>(base, header, PARTICLES);
+        Vec3* outlines = section<Vec3>(base, header, OUTLINES);
+        uint32_t particleCount = 0, outlineCount = 0;
+
+        PlayerRecord* ships = section<PlayerRecord>(base, header, PLAYER);
+        for (int i = 0; i < world.numShips(); ++i) {
+            const Player& player = world.ship(i);
+            PlayerRecord& p = ships[i];
+            p.home = vec(player.home);
+            p.pos = vec(player.pos);
+            p.velocity = vec(player.velocity);
+            p.acceleration = vec(player.acceleration);
+            p.explosionCenter = vec(player.explosionCenter);
+            p.rot = player.rot;
+            p.alpha = player.alpha;
+            p.fadeDirection = player.fadeDirection;
+            p.isExploding = player.isExploding;
+            p.invulnerable = player.invulnerable;
+            p.invulnerableTimeUp = player.invulnerableTimeUp;
+            p.explosionTimerTicks = world.timers.ticksRemaining(player.explosionTimer);
+            p.invulnerableTimerTicks = world.timers.ticksRemaining(player.invulnerableTimer);
+            if (i > 0) {
+                p.canFire = world.extraShips[i - 1].canFire;
+                p.fireTimerTicks = world.timers.ticksRemaining(world.extraShips[i - 1].fireTimer);
+            }
+            p.particleOffset = particleCount;
+            p.particleCount = uint32_t(player.explosionParticles.size());
+            for (const auto& particle : player.explosionParticles) {
+                particles[particleCount++] = { vec(particle.pos), vec(particle.vel), particle.lifespan, particle.age, particle.radius };
+            }
+        }
+
+        BulletRecord* bullets = section<BulletRecord>(base, header, BULLETS);
+        for (size_t i = 0; i < world.bullets.size(); ++i) {
+            *bullets++ = { vec(world.bullets.position(i)), vec(world.bullets.velocity(i)), world.bullets.angle(i),
+                world.tick - world.bullets.firedOn(i) };
+        }
+
+        AsteroidRecord* asteroids = section<AsteroidRecord>(base, header, ASTEROIDS);
+        for (const Asteroid& a : world.asteroids) {
+            saveAsteroid(a, *asteroids++, outlines, outlineCount, particles, particleCount);
+        }
+        AsteroidRecord* smallAsteroids = section<AsteroidRecord>(base, header, SMALL_ASTEROIDS);
+        for (const SmallAsteroid& a : world.smallAsteroids) {
+            saveAsteroid(a, *smallAsteroids++, outlines, outlineCount, particles, particleCount);
+        }
+
+        WellRecord* wells = section<WellRecord>(base, header, WELLS);
+        for (const GravityWell& well : world.wells) {
+            *wells++ = { vec(well.pos), well.mass };
+        }
+
+        uint32_t* despawns = section<uint32_t>(base, header, DESPAWNS);
+        for (const TimerWheel::Handle& h : world.despawnTimers) {
+            if (world.timers.isPending(h)) *despawns++ = world.timers.ticksRemaining(h);
+        }
+    }
+
+    // Rebuild world from a snapshot in memory (read or mapped from a file);
+    // false, with world untouched, if the bytes are not a valid snapshot
+    static bool restore(GameWorld& world, const char* bytes, size_t size) {
+        using namespace Snapshot;
+        MemoryScope memoryScope(MemoryTag::WORLD);
+
+        if (!validate(bytes, size)) return false;
+        Header header;
+        std::memcpy(&header, bytes, sizeof(Header));
+
+        const WorldRecord& w = *section<const WorldRecord>(bytes, header, WORLD);
+        world.seed = w.seed;
+        world.tick = w.tick;
+        world.worldSize = glm::vec2(w.width, w.height);
+        world.score = w.score;
+        world.playerDeaths = w.playerDeaths;
+        world.asteroidsDestroyed = w.asteroidsDestroyed;
+        world.timer = w.timer;
+        world.timesUp = w.timesUp != 0;
+        world.canFire = w.canFire != 0;
+        world.stressPopulation = w.stressPopulation;
+        world.roundLength = w.roundLength;
+        world.fireRate = w.fireRate;
+        world.minAsteroids = w.minAsteroids;
+        world.baseSides = w.baseSides;
+        world.destroyedPerSide = w.destroyedPerSide;
+        world.gravity = w.gravity != 0;
+        world.steering = GameWorld::Steering(w.steering);
+        world.nextEntityId = w.nextEntityId;
+        world.gravityField.theta = w.theta;
+        world.flowStrength = w.flowStrength;
+        world.lodSettings.nearRadius = w.lodNearRadius;
+        world.lodSettings.farRadius = w.lodFarRadius;
+        world.lodSettings.midInterval = w.lodMidInterval;
+        world.lodSettings.farInterval = w.lodFarInterval;
+        world.lodSettings.viewSize = glm::vec2(w.lodViewWidth, w.lodViewHeight);
+
+        // Timers are rebuilt from scratch below, the ships' first
+        world.timers.clear();
+        world.events.clear();
+        world.roundTimer = TimerWheel::Handle();
+        world.fireTimer = TimerWheel::Handle();
+        world.despawnTimers.clear();
+
+        const ParticleRecord* particles = section<const ParticleRecord>(bytes, header, PARTICLES);
+        const Vec3* outlines = section<const Vec3>(bytes, header, OUTLINES);
+
+        const PlayerRecord* ships = section<const PlayerRecord>(bytes, header, PLAYER);
+        world.shipCount = int(header.sections[PLAYER].count);
+        world.extraShips.clear();
+        for (uint32_t i = 0; i < header.sections[PLAYER].count; ++i) {
+            const PlayerRecord& p = ships[i];
+            if (i == 0) {
+                world.player.reset(new Player(world.timers, vec(p.home)));
+            }
+            else {
+                world.extraShips.emplace_back();
+                world.extraShips.back().ship.reset(new Player(world.timers, vec(p.home)));
+                world.extraShips.back().ship->color = GameWorld::shipColors()[i];
+                world.extraShips.back().canFire = p.canFire != 0;
+            }
+            Player& player = world.ship(int(i));
+            player.timers.cancel(player.invulnerableTimer);
+            player.pos = vec(p.pos);
+            player.velocity = vec(p.velocity);
+            player.acceleration = vec(p.acceleration);
+            player.explosionCenter = vec(p.explosionCenter);
+            player.rot = p.rot;
+            player.moved();
+            player.alpha = p.alpha;
+            player.fadeDirection = p.fadeDirection;
+            player.isExploding = p.isExploding != 0;
+            player.invulnerable = p.invulnerable != 0;
+            player.invulnerableTimeUp = p.invulnerableTimeUp != 0;
+            if (p.explosionTimerTicks > 0) player.armExplosionTimer(p.explosionTimerTicks);
+            if (p.invulnerableTimerTicks > 0) player.armInvulnerableTimer(p.invulnerableTimerTicks);
+            loadParticles(player.explosionParticles, particles + p.particleOffset, p.particleCount);
+        }
+
+        const Section& bulletSection = header.sections[BULLETS];
+        const BulletRecord* bullets = section<const BulletRecord>(bytes, header, BULLETS);
+        world.resetBullets();
+        if (bulletSection.count > world.bullets.capacity()) world.bullets.reset(bulletSection.count, world.bullets.lifetimeTicks);
+        for (uint32_t i = 0; i < bulletSection.count; ++i) {
+            world.bullets.add(vec(bullets[i].pos), vec(bullets[i].velocity), bullets[i].rot, world.tick - bullets[i].age);
+        }
+
+        loadAsteroids(world.asteroids, section<const AsteroidRecord>(bytes, header, ASTEROIDS), header.sections[ASTEROIDS].count,
+            outlines, particles);
+        loadAsteroids(world.smallAsteroids, section<const AsteroidRecord>(bytes, header, SMALL_ASTEROIDS), header.sections[SMALL_ASTEROIDS].count,
+            outlines, particles);
+
+        const WellRecord* wells = section<const WellRecord>(bytes, header, WELLS);
+        world.wells.clear();
+        for (uint32_t i = 0; i < header.sections[WELLS].count; ++i) {
+            world.wells.push_back({ vec(wells[i].pos), wells[i].mass });
+        }
+
+        // World timers
+        if (w.roundTimerTicks > 0) world.scheduleRoundEnd(w.roundTimerTicks);
+        if (w.fireTimerTicks > 0) world.scheduleFireCooldown(w.fireTimerTicks);
+        for (uint32_t i = 1; i < header.sections[PLAYER].count; ++i) {
+            if (ships[i].fireTimerTicks > 0) world.scheduleShipFireCooldown(i - 1, ships[i].fireTimerTicks);
+        }
+        const uint32_t* despawns = section<const uint32_t>(bytes, header, DESPAWNS);
+        for (uint32_t i = 0; i < header.sections[DESPAWNS].count; ++i) {
+            world.scheduleSweep(despawns[i]);
+        }
+
+        world.rng.setState(w.rng);
+        world.applyReferencePath();
+        if (world.steering == GameWorld::STEER_FLOW_FIELD) world.flowField.start(world.seed, world.worldSize, world.tick);
+        world.lodStats = SimLodStats();
+        return true;
+    }
+
+    static bool save(const GameWorld& world, const std::string& path) {
+        std::vector<char> bytes;
+        capture(world, bytes);
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(bytes.data(), std::streamsize(bytes.size()));
+        return bool(file);
+    }
+
+    static bool load(GameWorld& world, const std::string& path) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) return false;
+        std::vector<char> bytes(size_t(file.tellg()));
+        file.seekg(0);
+        file.read(bytes.data(), std::streamsize(bytes.size()));
+        return file && restore(world, bytes.data(), bytes.size());
+    }
+
+    // Header, version and every section's bounds; records are not inspected further
+    static bool validate(const char* bytes, size_t size) {
+        using namespace Snapshot;
+        if (size < sizeof(Header)) return false;
+
+        Header header;
+        std::memcpy(&header, bytes, sizeof(Header));
+        if (std::memcmp(header.magic, magic, 4) != 0 || header.version != version || header.byteOrder != byteOrderMark || header.size > size) return false;
+        if (header.sections[WORLD].count != 1) return false;
+        if (header.sections[PLAYER].count < 1 || header.sections[PLAYER].count > uint32_t(GameWorld::maxShips)) return false;
+
+        static const size_t recordSizes[NUM_SECTIONS] = {
+            sizeof(WorldRecord), sizeof(PlayerRecord), sizeof(BulletRecord), sizeof(AsteroidRecord), sizeof(AsteroidRecord),
+            sizeof(Vec3), sizeof(ParticleRecord), sizeof(WellRecord), sizeof(uint32_t)
+        };
+        for (int i = 0; i < NUM_SECTIONS; ++i) {
+            const Section& s = header.sections[i];
+            if (s.offset % 8 != 0 || s.offset < sizeof(Header) || uint64_t(s.offset) + uint64_t(s.count) * recordSizes[i] > header.size) return false;
+        }
+
+        // LOD intervals divide the asteroid index when bands change
+        const WorldRecord& w = *section<const WorldRecord>(bytes, header, WORLD);
+        if (w.lodMidInterval < 1 || w.lodFarInterval < 1) return false;
+
+        // Outline and particle references must stay inside their sections
+        uint32_t outlineCount = header.sections[OUTLINES].count;
+        uint32_t particleCount = header.sections[PARTICLES].count;
+        const PlayerRecord* ships = section<const PlayerRecord>(bytes, header, PLAYER);
+        for (uint32_t i = 0; i < header.sections[PLAYER].count; ++i) {
+            if (!fits(ships[i].particleOffset, ships[i].particleCount, particleCount)) return false;
+        }
+        for (SectionId id : { ASTEROIDS, SMALL_ASTEROIDS }) {
+            const AsteroidRecord* a = section<const AsteroidRecord>(bytes, header, id);
+            for (uint32_t i = 0; i < header.sections[id].count; ++i) {
+                if (a[i].outlineCount < 2 || !fits(a[i].outlineOffset, a[i].outlineCount, outlineCount)) return false;
+                if (!fits(a[i].particleOffset, a[i].particleCount, particleCount)) return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    static size_t align(size_t n) {
+        return (n + 7) & ~size_t(7);
+    }
+
+    template <typename T, typename Bytes>
+    static T* section(Bytes* base, const Snapshot::Header& header, int id) {
+        return reinterpret_cast<T*>(base + header.sections[id].offset);
+    }
+
+    static bool fits(uint32_t offset, uint32_t count, uint32_t total) {
+        return uint64_t(offset) + count <= total;
+    }
+
+    static Snapshot::Vec3 vec(const glm::vec3& v) { return { v.x, v.y, v.z }; }
+    static glm::vec3 vec(const Snapshot::Vec3& v) { return glm::vec3(v.x, v.y, v.z); }
+
+    template <typename T>
+    static void saveAsteroid(const T& a, Snapshot::AsteroidRecord& r, Snapshot::Vec3* outlines, uint32_t& outlineCount,
+        Snapshot::ParticleRecord* particles, uint32_t& particleCount) {
+        r.pos = vec(a.pos);
+        r.velocity = vec(a.velocity);
+        r.acceleration = vec(a.acceleration);
+        r.explosionCenter = vec(a.explosionCenter);
+        r.rot = a.rot;
+        r.rotationSpeed = a.rotationSpeed;
+        r.minRadius = a.minRadius;     // fixed by the size class, kept in the record for readers
+        r.maxRadius = a.maxRadius;
+        r.explosionAge = a.explosionAge;
+        r.explosionLifetime = a.explosionLifetime;
+        r.numSides = a.numSides;
+        r.lodInterval = a.lod.interval;
+        r.lodWait = a.lod.wait;
+        r.lodBehind = a.lod.behind;
+        r.id = a.id;
+        r.exploded = a.exploded;
+        r.hasBeenHit = a.hasBeenHit;
+
+        // The outline is a closed loop, so each segment's start point is enough
+        r.outlineOffset = outlineCount;
+        r.outlineCount = uint32_t(a.lines.size());
+        for (const auto& line : a.lines) outlines[outlineCount++] = vec(line.first);
+
+        r.particleOffset = particleCount;
+        r.particleCount = uint32_t(a.explosionParticles.size());
+        for (const auto& particle : a.explosionParticles) {
+            particles[particleCount++] = { vec(particle.pos), vec(particle.vel), particle.lifespan, particle.age, particle.radius };
+        }
+    }
+
+    template <typename T>
+    static void loadAsteroids(std::vector<T>& out, const Snapshot::AsteroidRecord* records, uint32_t count,
+        const Snapshot::Vec3* outlines, const Snapshot::ParticleRecord* particles) {
+        out.clear();
+        out.resize(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            const Snapshot::AsteroidRecord& r = records[i];
+            T& a = out[i];
+            a.pos = vec(r.pos);
+            a.velocity = vec(r.velocity);
+            a.acceleration = vec(r.acceleration);
+            a.explosionCenter = vec(r.explosionCenter);
+            a.rot = r.rot;
+            a.moved();
+            a.rotationSpeed = r.rotationSpeed;
+            a.explosionAge = r.explosionAge;
+            a.explosionLifetime = r.explosionLifetime;
+            a.numSides = r.numSides;
+            a.lod.interval = r.lodInterval;
+            a.lod.wait = r.lodWait;
+            a.lod.behind = r.lodBehind;
+            a.id = r.id;
+            a.exploded = r.exploded != 0;
+            a.hasBeenHit = r.hasBeenHit != 0;
+
+            const Snapshot::Vec3* points = outlines + r.outlineOffset;
+            a.lines.resize(r.outlineCount);
+            for (uint32_t k = 0; k < r.outlineCount; ++k) {
+                a.lines[k] = std::make_pair(vec(points[k]), vec(points[k + 1 == r.outlineCount ? 0 : k + 1]));
+            }
+            loadParticles(a.explosionParticles, particles + r.particleOffset, r.particleCount);
+        }
+    }
+
+    template <typename Particle>
+    static void loadParticles(std::vector<Particle>& out, const Snapshot::ParticleRecord* records, uint32_t count) {
+        out.resize(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            out[i].pos = vec(records[i].pos);
+            out[i].vel = vec(records[i].vel);
+            out[i].lifespan = records[i].lifespan;
+            out[i].age = records[i].age;
+            out[i].radius = records[i].radius;
+        }
+    }
+};
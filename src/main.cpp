@@ -1,8 +1,441 @@
 #include "ofMain.h"
 #include "ofApp.h"
+#include "GameWorld.h"
+#include "Replay.h"
+#include "WorldHash.h"
+#include "BatchRunner.h"
+#include "WorldSnapshot.h"
+#include "NetServer.h"
+#include "NetClient.h"
+#include "Telemetry.h"
+#include "MemoryTracker.h"
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+// Every heap allocation in the program goes through the memory tracker, so
+// the overlay, F7 and --memory-report can break it down by subsystem
+void* operator new(size_t size) {
+	if (void* p = MemoryTracker::allocate(size)) return p;
+	throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return MemoryTracker::allocate(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return MemoryTracker::allocate(size); }
+void operator delete(void* p) noexcept { MemoryTracker::release(p); }
+void operator delete[](void* p) noexcept { MemoryTracker::release(p); }
+void operator delete(void* p, size_t) noexcept { MemoryTracker::release(p); }
+void operator delete[](void* p, size_t) noexcept { MemoryTracker::release(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { MemoryTracker::release(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { MemoryTracker::release(p); }
+
+// Over-aligned types (alignas above 16), such as the telemetry ring
+void* operator new(size_t size, std::align_val_t alignment) {
+	if (void* p = MemoryTracker::allocateAligned(size, size_t(alignment))) return p;
+	throw std::bad_alloc();
+}
+void* operator new[](size_t size, std::align_val_t alignment) { return operator new(size, alignment); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return MemoryTracker::allocateAligned(size, size_t(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return MemoryTracker::allocateAligned(size, size_t(alignment)); }
+void operator delete(void* p, std::align_val_t) noexcept { MemoryTracker::release(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { MemoryTracker::release(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { MemoryTracker::release(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { MemoryTracker::release(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { MemoryTracker::release(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { MemoryTracker::release(p); }
+
+// Live heap by subsystem at the end of a headless run
+void printMemoryReport() {
+	MemoryStats stats;
+	stats.sample();
+	stats.report(std::cout);
+}
+
+// Run a recorded session without a window as fast as possible,
+// optionally writing the world hash of every tick to hashPath
+int runReplayHeadless(const std::string& path, const std::string& hashPath) {
+	ReplayPlayer replay;
+	if (!replay.open(path)) {
+		std::cerr << "could not open replay " << path << std::endl;
+		return 1;
+	}
+
+	GameWorld world;
+	world.stressPopulation = int(replay.header.stressPopulation);
+	world.gravity = replay.header.gravity != 0;
+	world.steering = GameWorld::Steering(replay.header.steering);
+	world.gravityField.theta = replay.header.theta;
+	world.lodSettings = Replay::lodSettings(replay.header);
+	world.start(replay.header.seed, replay.header.width, replay.header.height);
+
+	std::ofstream hashFile;
+	if (!hashPath.empty()) hashFile.open(hashPath);
+
+	auto startTime = std::chrono::steady_clock::now();
+	uint8_t input;
+	while (!world.timesUp && replay.next(input)) {
+		world.step(input);
+		if (hashFile.is_open()) {
+			hashFile << world.tick << " " << std::hex << hashWorld(world) << std::dec << "\n";
+		}
+	}
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+	std::cout << "ticks: " << world.tick << " (" << world.tick / float(replay.header.ticksPerSecond) << " s of play)" << std::endl;
+	std::cout << "replayed in " << ms << " ms" << std::endl;
+	std::cout << "score: " << world.score << ", deaths: " << world.playerDeaths
+		<< ", asteroids destroyed: " << world.asteroidsDestroyed << std::endl;
+	return 0;
+}
+
+// Step the reference and the optimized simulation side by side from the
+// same replay and report the first tick and entity where they disagree
+int runDifferential(const std::string& path) {
+	ReplayPlayer replay;
+	if (!replay.open(path)) {
+		std::cerr << "could not open replay " << path << std::endl;
+		return 1;
+	}
+
+	GameWorld reference, optimized;
+	reference.referencePath = true;
+	reference.stressPopulation = optimized.stressPopulation = int(replay.header.stressPopulation);
+	reference.gravity = optimized.gravity = replay.header.gravity != 0;
+	reference.steering = optimized.steering = GameWorld::Steering(replay.header.steering);
+	reference.gravityField.theta = optimized.gravityField.theta = replay.header.theta;
+	reference.lodSettings = optimized.lodSettings = Replay::lodSettings(replay.header);
+	reference.start(replay.header.seed, replay.header.width, replay.header.height);
+	optimized.start(replay.header.seed, replay.header.width, replay.header.height);
+
+	uint8_t input;
+	while (!reference.timesUp && replay.next(input)) {
+		reference.step(input);
+		optimized.step(input);
+
+		if (hashWorld(reference) != hashWorld(optimized)) {
+			std::cout << "diverged at tick " << reference.tick << ": "
+				<< findDivergence(reference, optimized) << std::endl;
+			return 1;
+		}
+	}
+
+	std::cout << "no divergence in " << reference.tick << " ticks, final hash "
+		<< std::hex << hashWorld(reference) << std::dec << std::endl;
+	return 0;
+}
+
+// Autopilot rounds back to back without a window, for soak tests under a
+// profiler; rounds = 0 keeps going until the process is killed. With
+// renderStats every tick is also drawn into a recording backend to report
+// draw calls and state changes per frame. Rounds start from snapshotPath
+// when given, and the last world is saved to savePath when given.
+int runAutopilotHeadless(const BatchRunner::Settings& settings, int rounds, bool renderStats,
+	const std::string& snapshotPath, const std::string& savePath, const std::string& telemetryPrefix) {
+	std::unique_ptr<GameWorld> world(new GameWorld());
+	settings.applyBalance(*world);
+	AutopilotPolicy autopilot;
+	RecordingRenderBackend recorder;
+	uint32_t maxTicks = TimerWheel::secondsToTicks(settings.roundLength);	// endless rounds stop here too, or this long after a snapshot
+	TelemetryLogger telemetry;
+	if (!telemetryPrefix.empty() && !telemetry.start(telemetryPrefix)) {
+		std::cerr << "could not write telemetry to " << telemetryPrefix << std::endl;
+		return 1;
+	}
+
+	for (int round = 0; rounds == 0 || round < rounds; round++) {
+		uint64_t seed = settings.baseSeed + uint64_t(round);
+		if (snapshotPath.empty()) {
+			world->start(seed, settings.width, settings.height);
+		}
+		else {
+			auto restoreStart = std::chrono::steady_clock::now();
+			if (!WorldSnapshot::load(*world, snapshotPath)) {
+				std::cerr << "could not restore snapshot " << snapshotPath << std::endl;
+				return 1;
+			}
+			seed = world->seed;
+			maxTicks = world->tick + TimerWheel::secondsToTicks(settings.roundLength);
+			std::cout << "restored tick " << world->tick << " in "
+				<< std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - restoreStart).count() << " ms" << std::endl;
+		}
+
+		uint32_t startTick = world->tick;
+		size_t peakAsteroids = 0, peakSmallAsteroids = 0, peakBullets = 0;
+		SimLodStats lodTotals;
+		long long commands = 0;
+		recorder.reset();
+		auto startTime = std::chrono::steady_clock::now();
+		while (!world->timesUp && world->tick < maxTicks) {
+			auto stepStart = std::chrono::steady_clock::now();
+			world->step(autopilot.nextInput(*world));
+			if (telemetry.isRunning()) {
+				float stepMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - stepStart).count();
+				telemetry.recordEvents(*world);
+				telemetry.recordFrame(*world, stepMs, 0, stepMs, 1.0f);
+			}
+			if (renderStats) {
+				world->draw(world->cameraView(settings.width, settings.height), recorder);
+				commands += world->renderQueue.stats.commands;
+				recorder.calls.clear();
+			}
+			peakAsteroids = std::max(peakAsteroids, world->asteroids.size());
+			peakSmallAsteroids = std::max(peakSmallAsteroids, world->smallAsteroids.size());
+			peakBullets = std::max(peakBullets, world->bullets.size());
+			lodTotals.fullUpdates += world->lodStats.fullUpdates;
+			lodTotals.catchUpUpdates += world->lodStats.catchUpUpdates;
+			lodTotals.skippedUpdates += world->lodStats.skippedUpdates;
+			lodTotals.skippedPairs += world->lodStats.skippedPairs;
+		}
+		uint32_t ticksRun = world->tick - startTick;
+		if (telemetry.isRunning()) telemetry.recordRound(*world);
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+		std::cout << "round " << round << " seed " << seed << ": score " << world->score
+			<< ", deaths " << world->playerDeaths << ", asteroids destroyed " << world->asteroidsDestroyed
+			<< ", peak asteroids " << peakAsteroids << "/" << peakSmallAsteroids << " small, peak bullets " << peakBullets
+			<< ", " << ticksRun / std::max(seconds, 1e-9) << " ticks/s" << std::endl;
+		if (lodTotals.catchUpUpdates + lodTotals.skippedUpdates > 0) {
+			double ticks = std::max(1u, ticksRun);
+			std::cout << "  simulation LOD per tick: " << lodTotals.fullUpdates / ticks << " full, "
+				<< lodTotals.catchUpUpdates / ticks << " catch-up, " << lodTotals.skippedUpdates / ticks << " skipped updates, "
+				<< lodTotals.skippedPairs / ticks << " skipped pairs" << std::endl;
+		}
+		if (renderStats && ticksRun > 0) {
+			std::cout << "  per frame: " << commands / double(ticksRun) << " commands, "
+				<< recorder.drawCalls / double(ticksRun) << " draw calls, "
+				<< recorder.stateChanges / double(ticksRun) << " state changes, "
+				<< recorder.vertices / double(ticksRun) << " vertices" << std::endl;
+		}
+	}
+
+	if (telemetry.isRunning()) {
+		telemetry.stop();
+		std::cout << "telemetry: " << telemetry.recordsWritten << " records written to " << telemetryPrefix << "-*.tlm, "
+			<< telemetry.dropped << " dropped" << std::endl;
+	}
+
+	if (!savePath.empty()) {
+		auto saveStart = std::chrono::steady_clock::now();
+		if (!WorldSnapshot::save(*world, savePath)) {
+			std::cerr << "could not save snapshot " << savePath << std::endl;
+			return 1;
+		}
+		std::cout << "saved tick " << world->tick << " to " << savePath << " in "
+			<< std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - saveStart).count() << " ms" << std::endl;
+	}
+	return 0;
+}
+
+// Authoritative multiplayer server on localhost, using the batch settings for balance
+int runNetServer(const BatchRunner::Settings& settings, uint16_t port, int ships, float seconds) {
+	NetServer server;
+	settings.applyBalance(server.world);
+	NetServer::Settings serverSettings;
+	serverSettings.port = port;
+	serverSettings.ships = ships;
+	serverSettings.seed = settings.baseSeed;
+	serverSettings.width = settings.width;
+	serverSettings.height = settings.height;
+	serverSettings.seconds = seconds;
+	if (!server.start(serverSettings)) return 1;
+	return server.run();
+}
+
+// Windowless client that mashes random keys at 60 Hz, for trying the server
+// and measuring what a client receives
+int runNetBot(uint16_t port, float seconds) {
+	NetClient client;
+	if (!client.connect(port)) {
+		std::cerr << "could not open a UDP socket" << std::endl;
+		return 1;
+	}
+	FastRandom rng(uint64_t(std::chrono::steady_clock::now().time_since_epoch().count()));
+	uint8_t input = 0;
+	int holdTicks = 0;
+
+	typedef std::chrono::steady_clock Clock;
+	auto tickLength = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / TimerWheel::ticksPerSecond));
+	auto next = Clock::now();
+	uint32_t ticks = TimerWheel::secondsToTicks(seconds > 0 ? seconds : 10.0f);
+	for (uint32_t t = 0; t < ticks; ++t) {
+		if (holdTicks-- <= 0) {
+			input = uint8_t(rng.next(0, 32)) & ~GameWorld::INPUT_QUIT;
+			holdTicks = int(rng.next(5, 40));
+		}
+		client.update(input, 1.0f / TimerWheel::ticksPerSecond);
+		next += tickLength;
+		std::this_thread::sleep_until(next);
+	}
+	client.disconnect();
+
+	if (client.ship < 0) {
+		std::cerr << "no answer from a server on port " << port << std::endl;
+		return 1;
+	}
+	const NetClient::Stats& stats = client.stats;
+	double states = double(std::max<uint64_t>(1, stats.states));
+	std::cout << "ship " << client.ship << ": " << stats.states << " states, " << stats.bytes / states << " bytes each, "
+		<< stats.bytes * 8 / 1000.0 / (ticks / double(TimerWheel::ticksPerSecond)) << " kbit/s, " << stats.rejected << " rejected, "
+		<< stats.underruns << " underruns, decode " << stats.decodeSeconds * 1e6 / states << " us per state" << std::endl;
+	return 0;
+}
+
+// Telemetry files to CSVs named after the first file
+int runTelemetryCsv(const std::vector<std::string>& paths) {
+	std::string out = paths[0].substr(0, paths[0].rfind(".tlm"));
+	size_t records = 0;
+	if (!TelemetryReader::toCsv(paths, out, records)) {
+		std::cerr << "could not convert telemetry, files must be written by this version" << std::endl;
+		return 1;
+	}
+	std::cout << records << " records to " << out << "-frames.csv, -events.csv and -rounds.csv" << std::endl;
+	return 0;
+}
 
 //========================================================================
-int main( ){
+// Options:
+//   --replay <file>   play back a recorded session (data/replays/last.replay is the last round)
+//   --speed <n>       replay at n times the recorded speed
+//   --headless        replay without a window as fast as possible and print the result
+//   --hashes <file>   with --headless, write the world hash of every tick
+//   --diff <file>     check the optimized simulation against the reference on a replay;
+//                     the reference runs brute-force collision, exact gravity and no
+//                     LOD, so replays where LOD bands or Barnes-Hut engage diverge by design
+//   --autopilot       the bot plays, restarting rounds until 'r'; with --headless,
+//                     plays --rounds <n> rounds (0 = forever) as fast as possible
+//                     using --seed and the balance overrides below
+//   --render-scale <s>  draw gameplay at s (0.5 - 1) of the window resolution
+//   --dynamic-scale   pick the render scale from what gameplay costs to draw
+//   --render-stats    with --headless --autopilot, draw every tick into a recording
+//                     backend and print draw calls and state changes per frame
+//   --stress <n>      endless round with n large asteroids in a world sized to fit them;
+//                     headless and batch runs stop after --round-length seconds
+//   --lod-near <r>    full simulation rate within r of the player (default 1500)
+//   --lod-far <r>     reduced rate out to r, lowest rate beyond (default 4000)
+//   --gravity         asteroids and gravity wells attract each other (Barnes-Hut)
+//   --theta <t>       gravity opening angle, 0 = exact, larger is faster (default 0.6)
+//   --random-walk     asteroids wander randomly instead of following the flow field
+//   --snapshot <file>   start play from a saved world (F5 saves one, F9 restores it);
+//                       with --headless --autopilot, every round starts from it
+//   --save-snapshot <file>  with --headless --autopilot, save the world after the last round
+//   --telemetry <prefix>    with --headless --autopilot, log frame, event and round records
+//                           to <prefix>-0000.tlm onwards (the game always logs to data/telemetry)
+//   --spike-budget <ms>     update or draw time that makes the flight recorder dump the last
+//                           five seconds and a snapshot to data/spikes (default 20, 0 = off)
+//   --memory-report   with --headless, print the heap by subsystem when the run ends
+//   --telemetry-csv <file>...  turn telemetry files, in the order written, into CSVs
+//   --server          localhost multiplayer server, runs until killed or --seconds pass
+//     --ships <n>           ships in the arena, 2 - 4 (default 2)
+//     --port <n>            UDP port (default 27960), also for --connect
+//     --seconds <s>         stop after s seconds
+//   --connect         play on the server; with --headless, a bot mashes keys for --seconds
+//                     (default 10) and prints what it received
+//   --batch <n>       run n headless sessions in parallel and write their stats to a CSV
+//     --threads <n>         worker threads (default: one per core)
+//     --policy <name>       input policy, random, scripted or autopilot
+//     --out <file>          CSV path (default batch.csv)
+//     --seed <n>            seed of the first session, session i uses seed + i
+//     --round-length <s>    balance overrides: round length in seconds,
+//     --fire-rate <s>       seconds between shots,
+//     --bullet-lifetime <s> seconds before a bullet expires,
+//     --min-asteroids <n>   large asteroids kept in play,
+//     --base-sides <n>      sides of new asteroids,
+//     --destroyed-per-side <n>  asteroids destroyed per extra side
+int main(int argc, char* argv[]){
+	std::string replayPath;
+	int replaySpeed = 1;
+	bool headless = false;
+	std::string hashPath;
+	std::string diffPath;
+	bool autopilot = false;
+	int autopilotRounds = 1;
+	bool renderStats = false;
+	float renderScale = 1.0f;
+	bool dynamicScale = false;
+	int batchSessions = 0;
+	std::string snapshotPath;
+	std::string saveSnapshotPath;
+	BatchRunner::Settings batch;
+	bool server = false;
+	bool connect = false;
+	int ships = 2;
+	uint16_t port = Net::defaultPort;
+	float seconds = 0;
+	std::string telemetryPrefix;
+	float spikeBudget = 20.0f;
+	bool memoryReport = false;
+	std::vector<std::string> telemetryFiles;
+
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--replay" && i + 1 < argc) replayPath = argv[++i];
+		else if (arg == "--speed" && i + 1 < argc) replaySpeed = std::max(1, atoi(argv[++i]));
+		else if (arg == "--headless") headless = true;
+		else if (arg == "--hashes" && i + 1 < argc) hashPath = argv[++i];
+		else if (arg == "--diff" && i + 1 < argc) diffPath = argv[++i];
+		else if (arg == "--autopilot") autopilot = true;
+		else if (arg == "--render-stats") renderStats = true;
+		else if (arg == "--render-scale" && i + 1 < argc) renderScale = ofClamp(float(atof(argv[++i])), 0.5f, 1.0f);
+		else if (arg == "--dynamic-scale") dynamicScale = true;
+		else if (arg == "--lod-near" && i + 1 < argc) batch.lod.nearRadius = float(atof(argv[++i]));
+		else if (arg == "--lod-far" && i + 1 < argc) batch.lod.farRadius = float(atof(argv[++i]));
+		else if (arg == "--gravity") batch.gravity = true;
+		else if (arg == "--snapshot" && i + 1 < argc) snapshotPath = argv[++i];
+		else if (arg == "--save-snapshot" && i + 1 < argc) saveSnapshotPath = argv[++i];
+		else if (arg == "--random-walk") batch.steering = GameWorld::STEER_RANDOM_WALK;
+		else if (arg == "--theta" && i + 1 < argc) batch.theta = std::max(0.0f, float(atof(argv[++i])));
+		else if (arg == "--stress" && i + 1 < argc) batch.stressPopulation = std::max(0, atoi(argv[++i]));
+		else if (arg == "--rounds" && i + 1 < argc) autopilotRounds = std::max(0, atoi(argv[++i]));
+		else if (arg == "--spike-budget" && i + 1 < argc) spikeBudget = std::max(0.0f, float(atof(argv[++i])));
+		else if (arg == "--memory-report") memoryReport = true;
+		else if (arg == "--telemetry" && i + 1 < argc) telemetryPrefix = argv[++i];
+		else if (arg == "--telemetry-csv") {
+			while (i + 1 < argc && std::string(argv[i + 1]).compare(0, 2, "--") != 0) telemetryFiles.push_back(argv[++i]);
+		}
+		else if (arg == "--server") server = true;
+		else if (arg == "--connect") connect = true;
+		else if (arg == "--ships" && i + 1 < argc) ships = atoi(argv[++i]);
+		else if (arg == "--port" && i + 1 < argc) port = uint16_t(atoi(argv[++i]));
+		else if (arg == "--seconds" && i + 1 < argc) seconds = float(atof(argv[++i]));
+		else if (arg == "--batch" && i + 1 < argc) batchSessions = std::max(1, atoi(argv[++i]));
+		else if (arg == "--threads" && i + 1 < argc) batch.threads = atoi(argv[++i]);
+		else if (arg == "--policy" && i + 1 < argc) batch.policy = argv[++i];
+		else if (arg == "--out" && i + 1 < argc) batch.csvPath = argv[++i];
+		else if (arg == "--seed" && i + 1 < argc) batch.baseSeed = strtoull(argv[++i], nullptr, 10);
+		else if (arg == "--round-length" && i + 1 < argc) batch.roundLength = float(atof(argv[++i]));
+		else if (arg == "--fire-rate" && i + 1 < argc) batch.fireRate = float(atof(argv[++i]));
+		else if (arg == "--bullet-lifetime" && i + 1 < argc) batch.bulletLifetime = float(atof(argv[++i]));
+		else if (arg == "--min-asteroids" && i + 1 < argc) batch.minAsteroids = atoi(argv[++i]);
+		else if (arg == "--base-sides" && i + 1 < argc) batch.baseSides = atoi(argv[++i]);
+		else if (arg == "--destroyed-per-side" && i + 1 < argc) batch.destroyedPerSide = std::max(1, atoi(argv[++i]));
+	}
+
+	if (batchSessions > 0) {
+		batch.sessions = batchSessions;
+		return BatchRunner().run(batch);
+	}
+	if (!telemetryFiles.empty()) {
+		return runTelemetryCsv(telemetryFiles);
+	}
+	if (server) {
+		return runNetServer(batch, port, ships, seconds);
+	}
+	if (headless && connect) {
+		return runNetBot(port, seconds);
+	}
+	if (!diffPath.empty()) {
+		return runDifferential(diffPath);
+	}
+	if (headless && !replayPath.empty()) {
+		int result = runReplayHeadless(replayPath, hashPath);
+		if (memoryReport) printMemoryReport();
+		return result;
+	}
+	if (headless && autopilot) {
+		int result = runAutopilotHeadless(batch, autopilotRounds, renderStats, snapshotPath, saveSnapshotPath, telemetryPrefix);
+		if (memoryReport) printMemoryReport();
+		return result;
+	}
 
 	//Use ofGLFWWindowSettings for more options like multi-monitor fullscreen
 	ofGLWindowSettings settings;
@@ -11,6 +444,22 @@ int main( ){
 
 	auto window = ofCreateWindow(settings);
 
-	ofRunApp(window, make_shared<ofApp>());
+	auto app = make_shared<ofApp>();
+	app->replayPath = replayPath;
+	app->replaySpeed = replaySpeed;
+	app->snapshotPath = snapshotPath;
+	app->autopilot = autopilot;
+	app->connectPort = connect ? port : 0;
+	app->flightRecorder.budgetMs = spikeBudget;
+	app->stressPopulation = batch.stressPopulation;
+	app->lodSettings = batch.lod;
+	app->theta = batch.theta;
+	app->gravity = batch.gravity;
+	app->steering = batch.steering;
+	app->renderScale = renderScale;
+	app->dynamicScale = dynamicScale;
+	app->dynamicResolution.scale = renderScale;
+
+	ofRunApp(window, app);
 	ofRunMainLoop();
 }
@@ -2,8 +2,13 @@
 
 //--------------------------------------------------------------
 void ofApp::setup() {
-    // Loading background image
-    background.load("BG/stars.png");
+    // Images, fonts and sounds are charged to assets; world and telemetry
+    // allocations below set their own tags
+    MemoryScope memoryScope(MemoryTag::ASSETS);
+
+    // Loading background image, scaled to the window here rather than every frame
+    backgroundSource.load("BG/stars.png");
+    scaleBackground();
 
     // Loading fonts, different sizes for title and normal text
     titleFont.load("FONT/VideoPhreak.ttf", 50);
@@ -29,122 +34,179 @@ void ofApp::setup() {
 
     asteroidHitSound.load("SFX/asteroidhit.wav");
     asteroidHitSound.setMultiPlay(true);
+
+    flightRecorder.directory = ofToDataPath("spikes", true);
+
+    // Telemetry for the whole session, one set of files per launch
+    ofDirectory::createDirectory("telemetry", true, true);
+    if (!telemetry.start(ofToDataPath("telemetry/" + ofGetTimestampString("%Y%m%d-%H%M%S"), true))) {
+        ofLogWarning("ofApp") << "could not open telemetry log";
+    }
+
+    // Replay given on the command line
+    if (!replayPath.empty()) {
+        startReplay(replayPath);
+    }
+    // Snapshot given on the command line
+    else if (!snapshotPath.empty()) {
+        restoreSnapshot(snapshotPath);
+    }
+    // Joining a server goes straight into play; the world here stays unused
+    else if (connectPort != 0) {
+        autopilot = false;
+        if (netClient.connect(connectPort)) gameState = GAMEPLAY;
+        else ofLogError("ofApp") << "could not open a UDP socket";
+    }
+    // Autopilot from the command line goes straight into a round
+    else if (autopilot) {
+        gameState = GAMEPLAY;
+        startGame();
+    }
 }
 
 //--------------------------------------------------------------
 void ofApp::update() {
+    // Everything allocated from the frame arena last frame is released here
+    frameArena().reset();
+    memoryStats.sample();
+
     // Checks if the game is in the play state
     if (gameState != GAMEPLAY) { return; }
 
-    // Count Down Timer 
-    if (!timesUp) {
-        // Decrease the timer by the elapsed time; 2 minutes to play
-        timer -= ofGetLastFrameTime(); 
-
-        // Timer Finished, Exit to the Game Over Screen
-        if (timer <= 0) {
-            timer = 0;
-            timesUp = true;
-            gameState = ENDSCREEN;
+    // Networked play: the server runs the world, this sends input and interpolates its states
+    if (netClient.isOpen()) {
+        uint8_t input = currentInput();
+        if (input & GameWorld::INPUT_QUIT) {
+            netClient.disconnect();
+            ofExit();
+            return;
         }
+        netClient.update(input, float(ofGetLastFrameTime()));
+        return;
     }
 
-    // Handle player movement
-    if (moveLeft) { player->rotate(-5.0f); }
-    if (moveRight) { player->rotate(5.0f); }
-    if (moveForward) { player->thrust(0.1f); }
-    if (moveBackward) { player->thrust(-0.1f); }
-
-    player->update();
-    bulletSystem->update();
-
-    // Handle shooting
-    float currentTime = ofGetElapsedTimef();
-    if (shooting && (currentTime - lastShotTime >= fireRate) && !player->invulnerable && !player->isExploding) {
-        bulletSystem->emit(player->pos, player->rot, 8.0f, player->velocity);
-        lastShotTime = currentTime;
-        shootSound.play();
+    // Effects quality for this frame's explosions from last frame's cost
+    effectsQuality() = effectsGovernor.update(updateSeconds, drawSeconds);
+    auto updateStart = std::chrono::steady_clock::now();
+    flightRecorder.beginFrame();
+
+    // Ticks owed for the time since the last frame, whatever the frame rate
+    int ticks = ticksDue(ofGetLastFrameTime());
+
+    if (replaying) {
+        // Feed the recorded input, replaySpeed times as fast as it was played
+        for (int i = 0; i < ticks * replaySpeed && !world.timesUp; i++) {
+            uint8_t input;
+            if (!replayPlayer.next(input)) {
+                world.timesUp = true;
+                break;
+            }
+            world.step(input);
+            flightRecorder.afterStep(world, input);
+            playEventSounds();
+            flightRecorder.lap(FlightRecorder::SOUNDS);
+            telemetry.recordEvents(world);
+            flightRecorder.lap(FlightRecorder::TELEMETRY);
+        }
     }
-
-    // Update large asteroids
-    for (Asteroid& asteroid : asteroids) {
-        asteroid.update();
-        asteroid.updateExplosion();
+    else {
+        // Live play, every tick's input goes to the recording
+        for (int i = 0; i < ticks && !world.timesUp; i++) {
+            uint8_t input = currentInput();
+            replayRecorder.record(input);
+            world.step(input);
+            flightRecorder.afterStep(world, input);
+            playEventSounds();
+            flightRecorder.lap(FlightRecorder::SOUNDS);
+            telemetry.recordEvents(world);
+            flightRecorder.lap(FlightRecorder::TELEMETRY);
+        }
     }
 
-    // Update all small asteroids
-    for (SmallAsteroid& smallAsteroid : smallAsteroids) {
-        smallAsteroid.update();
-        smallAsteroid.updateExplosion();
+    // Stopping player sounds if it is hit
+    if (world.player->isExploding) {
+        if (thrustSound.isPlaying()) thrustSound.stop();
+        if (whirlSound.isPlaying()) whirlSound.stop();
+        if (shootSound.isPlaying()) shootSound.stop();
     }
 
-    // Check for bullet collisions with large asteroids
-    if (collisionSystem.BulletLargeAsteroidCollision(bulletSystem->particles, asteroids, smallAsteroids)) {
-        score += 100;
-        asteroidHitSound.play();
-        asteroidsDestroyed++;
-        spawnAsteroids();
-    }
+    updateSeconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - updateStart).count();
+    telemetry.recordFrame(world, updateSeconds * 1000.0f, drawSeconds * 1000.0f, float(ofGetLastFrameTime() * 1000.0), renderScale);
 
-    // Check for bullet collisions with small asteroids
-    if (collisionSystem.BulletSmallAsteroidCollision(bulletSystem->particles, smallAsteroids)) {
-        score += 50;
-        asteroidHitSound.play();
-        asteroidsDestroyed++;
+    // Timer Finished or player quit, Exit to the Game Over Screen
+    // The autopilot starts the next round instead, for soak runs
+    if (world.timesUp) {
+        telemetry.recordRound(world);
+        replayRecorder.close();
+        if (autopilot && !replaying) startGame();
+        else gameState = ENDSCREEN;
     }
+}
 
-    // Check player collision with large asteroids
-    if (collisionSystem.PlayerLargeAsteroidCollision(*player, asteroids)) {
-        score = std::max(0, score - 75);
-        playerHitSound.play();
-        playerDeaths++;
+// World ticks to run this frame. Round time, cooldowns and explosions count
+// ticks, so the world keeps to ticksPerSecond of real time at any frame rate;
+// after a long stall the backlog is dropped rather than run all at once.
+int ofApp::ticksDue(double frameSeconds) {
+    const double tickSeconds = 1.0 / TimerWheel::ticksPerSecond;
+    tickAccumulator += frameSeconds;
+    int ticks = int(tickAccumulator / tickSeconds);
+    if (ticks > maxTicksPerFrame) {
+        ticks = maxTicksPerFrame;
+        tickAccumulator = 0;
     }
-
-    // Check player collision with small asteroids
-    if (collisionSystem.PlayerSmallAsteroidCollision(*player, smallAsteroids)) {
-        score = std::max(0, score - 75);
-        playerHitSound.play();
-        playerDeaths++;
+    else {
+        tickAccumulator -= ticks * tickSeconds;
     }
+    return ticks;
+}
 
-    // Stopping player sounds if it is hit
-    if (player->isExploding) {
-        if (thrustSound.isPlaying()) thrustSound.stop();
-        if (whirlSound.isPlaying()) whirlSound.stop();
-        if (shootSound.isPlaying()) shootSound.stop();
+// Input bitmask for this tick from the keyboard flags, or from the autopilot
+uint8_t ofApp::currentInput() {
+    uint8_t input = 0;
+    if (autopilot) {
+        input = autopilotPolicy.nextInput(world);
     }
+    else {
+        if (moveLeft) input |= GameWorld::INPUT_LEFT;
+        if (moveRight) input |= GameWorld::INPUT_RIGHT;
+        if (moveForward) input |= GameWorld::INPUT_FORWARD;
+        if (moveBackward) input |= GameWorld::INPUT_BACKWARD;
+        if (shooting) input |= GameWorld::INPUT_SHOOT;
+    }
+    if (quitRequested) {
+        input |= GameWorld::INPUT_QUIT;
+        quitRequested = false;
+        autopilot = false;      // quitting ends the soak run too
+    }
+    return input;
+}
 
-    // Check collision between large asteroids
-    collisionSystem.LargeAsteroidCollision(asteroids);
-
-    // Check collision between large and small asteroids as well
-    collisionSystem.LargeSmallAsteroidCollision(asteroids, smallAsteroids);
+// Sound effects for the events of the last world tick
+void ofApp::playEventSounds() {
+    bool shot = false;
+    bool asteroidHit = false;
+    bool playerHit = false;
 
-    // Check the game to see if at least 7 asteroids are in play
-    if (asteroids.size() < 7 && smallAsteroids.size() <= 0) {
-        spawnAsteroids();
+    for (const GameEvent& e : world.events) {
+        if (e.type == GameEvent::SHOT) shot = true;
+        else if (e.type == GameEvent::ASTEROID_HIT) asteroidHit = true;
+        else if (e.type == GameEvent::PLAYER_DEATH) playerHit = true;
     }
 
-    // Remove large asteroids after explosions have finished
-    asteroids.erase(
-        std::remove_if(asteroids.begin(), asteroids.end(),
-            [](const Asteroid& a) { return a.isExplosionFinished(); }),
-        asteroids.end()
-    );
-
-    // Remove small asteroids after explosions have finished
-    smallAsteroids.erase(
-        std::remove_if(smallAsteroids.begin(), smallAsteroids.end(),
-            [](const SmallAsteroid& a) { return a.isExplosionFinished(); }),
-        smallAsteroids.end()
-    );
+    // One trigger per sound no matter how many events asked for it
+    if (shot) shootSound.play();
+    if (asteroidHit) asteroidHitSound.play();
+    if (playerHit) playerHitSound.play();
 }
 
 
 //--------------------------------------------------------------
 void ofApp::draw() {
+    // Screens, HUD and overlay text; the world's drawing is charged to render
+    MemoryScope memoryScope(MemoryTag::UI);
+
     // Background Image
-    background.draw(0, 0, ofGetWidth(), ofGetHeight());
+    background.draw(0, 0);
 
     // Drawing Start Scree n
     if (gameState == START) {
@@ -154,42 +216,192 @@ void ofApp::draw() {
     else if (gameState == INSTRUCTIONS) {
         instructionsScreen();
     }
+    // Drawing a networked game
+    else if (gameState == GAMEPLAY && netClient.isOpen()) {
+        drawNetworkedGame();
+    }
     // Drawing Play Screen
     else if (gameState == GAMEPLAY) {
-        player->draw();
-        bulletSystem->draw();
-
-        for (Asteroid& asteroid : asteroids) {
-            asteroid.draw();
-            asteroid.drawExplosion();
-        }
-
-        for (SmallAsteroid& smallAsteroid : smallAsteroids) {
-            smallAsteroid.draw();
-            smallAsteroid.drawExplosion();
+        // Scale from the last frame's render cost, not the frame interval
+        if (dynamicScale) {
+            renderScale = dynamicResolution.update(std::max(drawSeconds, gpuTimer.seconds));
         }
+        auto drawStart = std::chrono::steady_clock::now();
+        flightRecorder.mark();
+        if (dynamicScale) gpuTimer.begin();
+        drawGameplayLayer();
+        if (dynamicScale) gpuTimer.end();
+        flightRecorder.lap(FlightRecorder::DRAW_WORLD);
+        drawSeconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - drawStart).count();
 
         // Setting up Score Counter Display
+        // HUD text is formatted into the frame arena; it is short enough to
+        // stay in std::string's inline buffer when handed to the font
         ofSetColor(255);
-        textFont.drawString("Score: " + ofToString(score), 5, 25);
+        textFont.drawString(frameArena().format("Score: %d", world.score), 5, 25);
 
         // Setting up Timer Display
-        string timerText = "Time: " + ofToString(int(timer)); // Convert the float to an integer
+        const char* timerText = frameArena().format("Time: %d", int(world.timer)); // Convert the float to an integer
         ofRectangle timerRect = textFont.getStringBoundingBox(timerText, 0, 0);
         float timerX = ofGetWidth() / 2 - timerRect.getWidth() / 2;
         textFont.drawString(timerText, timerX, 25);
+
+        // Live load for stress rounds
+        if (world.isEndless()) {
+            textFont.drawString(frameArena().format("Asteroids: %zu + %zu small", world.asteroids.size(), world.smallAsteroids.size()), 5, 60);
+            textFont.drawString(frameArena().format("Frame: %.2f ms", ofGetLastFrameTime() * 1000.0), 5, 95);
+        }
+
+        if (replaying) {
+            ofSetColor(0, 255, 0);
+            textFont.drawString(frameArena().format("REPLAY x%d", replaySpeed), 5, ofGetHeight() - 10);
+            ofSetColor(255);
+        }
+        else if (autopilot) {
+            ofSetColor(0, 255, 0);
+            textFont.drawString("AUTOPILOT", 5, ofGetHeight() - 10);
+            ofSetColor(255);
+        }
+
+        // A frame over budget is dumped with the seconds before it
+        flightRecorder.lap(FlightRecorder::DRAW_HUD);
+        if (flightRecorder.endFrame(world, updateSeconds * 1000.0f, float(ofGetLastFrameTime() * 1000.0), effectsGovernor.level)) {
+            ofLogWarning("ofApp") << "frame over the " << flightRecorder.budgetMs << " ms budget at tick " << world.tick
+                << ", flight recorder writing " << flightRecorder.lastDump;
+        }
     }
     // Drawing End Screen
     else if (gameState == ENDSCREEN) {
         endGame();
     }
 
+    if (showDebugOverlay) {
+        drawDebugOverlay();
+    }
+}
+
+// The client's interpolated frame around our ship, with the score and time
+// the server sent; F3 adds the connection stats
+void ofApp::drawNetworkedGame() {
+    ofSetColor(255);
+    if (!netClient.hasFrame()) {
+        textFont.drawString("CONNECTING...", 5, 25);
+        return;
+    }
+
+    ofRectangle view = netClient.cameraView(ofGetWidth(), ofGetHeight());
+    ofPushMatrix();
+    ofTranslate(-view.x, -view.y);
+    netClient.draw(view, renderBackend);
+    ofPopMatrix();
+
+    ofSetColor(255);
+    textFont.drawString(frameArena().format("Score: %d", netClient.frame.score), 5, 25);
+    const char* timerText = frameArena().format("Time: %d", int(netClient.frame.timeLeft));
+    ofRectangle timerRect = textFont.getStringBoundingBox(timerText, 0, 0);
+    textFont.drawString(timerText, ofGetWidth() / 2 - timerRect.getWidth() / 2, 25);
+
+    if (showDebugOverlay) {
+        const NetClient::Stats& stats = netClient.stats;
+        ofSetColor(0, 255, 0);
+        ofDrawBitmapString(frameArena().format("ship %d: %llu states, %.0f bytes each, %llu rejected, %llu underruns, decode %.1f us",
+            netClient.ship, (unsigned long long)stats.states, stats.bytes / double(std::max<uint64_t>(1, stats.states)),
+            (unsigned long long)stats.rejected, (unsigned long long)stats.underruns,
+            stats.decodeSeconds * 1e6 / double(std::max<uint64_t>(1, stats.states))), 5, ofGetHeight() - 65);
+        ofSetColor(255);
+    }
+}
+
+// Worlds bigger than the window are drawn around the player. Below full
+// scale the world goes into the offscreen layer first, which is then
+// stretched over the window
+void ofApp::drawGameplayLayer() {
+    MemoryScope memoryScope(MemoryTag::RENDER);
+    ofRectangle view = world.cameraView(ofGetWidth(), ofGetHeight());
+    if (renderScale >= 1.0f) {
+        ofPushMatrix();
+        ofTranslate(-view.x, -view.y);
+        world.draw(view, renderBackend);
+        ofPopMatrix();
+        return;
+    }
+
+    int layerWidth = std::max(1, int(ofGetWidth() * renderScale));
+    int layerHeight = std::max(1, int(ofGetHeight() * renderScale));
+    if (!gameplayLayer.isAllocated() || int(gameplayLayer.getWidth()) != layerWidth || int(gameplayLayer.getHeight()) != layerHeight) {
+        gameplayLayer.allocate(layerWidth, layerHeight, GL_RGBA);
+    }
+
+    gameplayLayer.begin();
+    ofClear(0, 0, 0, 0);
+    ofPushMatrix();
+    ofScale(renderScale, renderScale);
+    ofTranslate(-view.x, -view.y);
+    world.draw(view, renderBackend);
+    ofPopMatrix();
+    gameplayLayer.end();
+
+    ofSetColor(255);
+    gameplayLayer.draw(0, 0, ofGetWidth(), ofGetHeight());
+}
+
+void ofApp::scaleBackground() {
+    if (!backgroundSource.isAllocated()) return;
+    background = backgroundSource;
+    background.resize(ofGetWidth(), ofGetHeight());
+}
+
+// Developer stats, toggled with F3
+void ofApp::drawDebugOverlay() {
+    FrameArena& arena = frameArena();
+    ofSetColor(0, 255, 0);
+    ofDrawBitmapString(arena.format("fps: %.1f", ofGetFrameRate()), 5, ofGetHeight() - 50);
+    ofDrawBitmapString(arena.format("frame arena: %zu / %zu bytes, %d heap fallbacks",
+        arena.lastFrameBytes, arena.capacity(), arena.lastFrameFallbacks), 5, ofGetHeight() - 35);
+    ofDrawBitmapString(arena.format("telemetry: %llu records written, %llu dropped",
+        (unsigned long long)telemetry.recordsWritten.load(), (unsigned long long)telemetry.dropped), 5, ofGetHeight() - 155);
+    ofDrawBitmapString(arena.format("flight recorder: %.0f ms budget, %d dumps, %d skipped, %d failed",
+        flightRecorder.budgetMs, flightRecorder.dumps, flightRecorder.skipped, flightRecorder.failed), 5, ofGetHeight() - 170);
+    ofDrawBitmapString(arena.format("heap: %.1f MB live, %+.1f MB since round start, %llu allocations last frame (F7 dumps)",
+        memoryStats.totalLiveBytes() / 1048576.0, memoryStats.growthBytes() / 1048576.0,
+        (unsigned long long)memoryStats.totalRecentAllocations()), 5, ofGetHeight() - 185);
+    const MemoryStats::Tag* tags = memoryStats.tags;
+    ofDrawBitmapString(arena.format("heap KB: world %.0f, shapes %.0f, particles %.0f, collision %.0f, render %.0f, assets %.0f, ui %.0f, other %.0f",
+        tags[int(MemoryTag::WORLD)].liveBytes / 1024.0, tags[int(MemoryTag::SHAPES)].liveBytes / 1024.0,
+        tags[int(MemoryTag::PARTICLES)].liveBytes / 1024.0, tags[int(MemoryTag::COLLISION)].liveBytes / 1024.0,
+        tags[int(MemoryTag::RENDER)].liveBytes / 1024.0, tags[int(MemoryTag::ASSETS)].liveBytes / 1024.0,
+        tags[int(MemoryTag::UI)].liveBytes / 1024.0, tags[int(MemoryTag::OTHER)].liveBytes / 1024.0), 5, ofGetHeight() - 200);
+    if (world.isStarted()) {
+        ofDrawBitmapString(arena.format("tick %u, world hash %016llx", world.tick, (unsigned long long)hashWorld(world)), 5, ofGetHeight() - 20);
+        ofDrawBitmapString(arena.format("culling: %d tested, %d culled, %d ghosts, %zu drawn",
+            world.culler.tested, world.culler.culled, world.culler.ghosts, world.culler.items.size()), 5, ofGetHeight() - 65);
+        ofDrawBitmapString(arena.format("effects: level %d of %d, update + draw %.2f ms", effectsGovernor.level,
+            EffectsGovernor::numLevels - 1, effectsGovernor.smoothed * 1000.0f), 5, ofGetHeight() - 110);
+        ofDrawBitmapString(arena.format("render scale: %d%%%s, render %.2f ms cpu, %.2f ms gpu", int(renderScale * 100 + 0.5f),
+            dynamicScale ? " (dynamic)" : "", drawSeconds * 1000.0f, gpuTimer.seconds * 1000.0f), 5, ofGetHeight() - 95);
+        if (world.steering == GameWorld::STEER_FLOW_FIELD) {
+            ofDrawBitmapString(arena.format("flow field: %d stalls waiting for the worker", world.flowField.stalls), 5, ofGetHeight() - 140);
+        }
+        const SimLodStats& lod = world.lodStats;
+        ofDrawBitmapString(arena.format("simulation LOD: %d full, %d catch-up, %d skipped updates, %d skipped pairs",
+            lod.fullUpdates, lod.catchUpUpdates, lod.skippedUpdates, lod.skippedPairs), 5, ofGetHeight() - 125);
+        const RenderQueue::Stats& render = world.renderQueue.stats;
+        ofDrawBitmapString(arena.format("render: %d commands in %d batches, %d colour changes, %d vertices",
+            render.commands, render.batches, render.colorChanges, render.vertices), 5, ofGetHeight() - 80);
+    }
+    ofSetColor(255);
 }
 
 //--------------------------------------------------------------
 void ofApp::keyPressed(int key) {
+    // Only leaving is possible while a replay plays
+    if (gameState == GAMEPLAY && replaying) {
+        if (key == 'r') {
+            gameState = ENDSCREEN;
+        }
+    }
     // Enable gameplay movements and shooting
-    if (gameState == GAMEPLAY) {
+    else if (gameState == GAMEPLAY) {
         if (key == OF_KEY_LEFT || key == 'a') {
             moveLeft = true;
             if (!whirlSound.isPlaying()) whirlSound.play();
@@ -206,15 +418,46 @@ void ofApp::keyPressed(int key) {
             moveBackward = true;
             if (!thrustSound.isPlaying()) thrustSound.play();
         }
-        if (key == ' ' && !player->invulnerable && !player->isExploding) {
+        // Networked ships are checked by the server
+        bool canShoot = netClient.isOpen() || (!world.player->invulnerable && !world.player->isExploding);
+        if (key == ' ' && canShoot) {
             shooting = true;
             if (!shootSound.isPlaying()) shootSound.play();
         }
-        // Player can exit gameplay by pressing 'r'
+        // Player can exit gameplay by pressing 'r', ends the round on the next tick
         if (key == 'r') {
-            gameState = ENDSCREEN;
+            quitRequested = true;
+        }
+        // Hand the ship to the autopilot and back
+        if (key == 'p' && !netClient.isOpen()) {
+            autopilot = !autopilot;
         }
     }
+
+    // Debug overlay can be toggled on any screen
+    if (key == OF_KEY_F3) {
+        showDebugOverlay = !showDebugOverlay;
+    }
+    // Render scale: F4 steps 100% -> 75% -> 50%, F6 hands it to the dynamic governor
+    if (key == OF_KEY_F4) {
+        dynamicScale = false;
+        renderScale = renderScale > 0.8f ? 0.75f : renderScale > 0.6f ? 0.5f : 1.0f;
+    }
+    if (key == OF_KEY_F6) {
+        dynamicScale = !dynamicScale;
+        dynamicResolution.scale = renderScale;
+    }
+    // Memory by subsystem, to the log and data/memory
+    if (key == OF_KEY_F7) {
+        dumpMemoryReport();
+    }
+    // Quick save and restore of the running world
+    if (key == OF_KEY_F5 && gameState == GAMEPLAY && !netClient.isOpen()) {
+        saveSnapshot(quickSnapshotPath());
+    }
+    if (key == OF_KEY_F9 && !netClient.isOpen()) {
+        restoreSnapshot(quickSnapshotPath());
+    }
 }
 
 
@@ -345,7 +588,7 @@ void ofApp::mouseExited(int x, int y) {
 
 //--------------------------------------------------------------
 void ofApp::windowResized(int w, int h) {
-
+    scaleBackground();
 }
 
 //--------------------------------------------------------------
@@ -358,31 +601,6 @@ void ofApp::dragEvent(ofDragInfo dragInfo) {
 
 }
 
-// Asteroids Spawner to populate game while playing
-void ofApp::spawnAsteroids() {
-    // At least 7 asteroids must be in the game at any time
-    int minAsteroids = 7;
-    int numNewAsteroids = minAsteroids - asteroids.size();
-    if (numNewAsteroids <= 0) {
-        return;
-    }
-
-    // New asteroids added based on the number destroyed
-    for (int i = 0; i < numNewAsteroids; i++) {
-        glm::vec3 randomPos;
-        float distanceToPlayer = 0;
-
-        // Make sure asteroids spawn away from player
-        do {
-            randomPos = glm::vec3(ofRandomWidth(), ofRandomHeight(), 0);
-            distanceToPlayer = glm::distance(randomPos, player->pos);
-        } while (distanceToPlayer < minDistanceFromPlayer);
-
-        int sizeFactor = 10 + (asteroidsDestroyed / 10);
-        asteroids.push_back(Asteroid(randomPos, sizeFactor));
-    }
-}
-
 void ofApp::startScreen() {
     // "ASTEROID ACCERATION" Title 
     ofSetColor(0, 255, 0);
@@ -456,40 +674,100 @@ void ofApp::instructionsScreen() {
 }
 
 void ofApp::startGame() {
-    // Delete old player and particle system if still active
-    if (player) delete player;
-    if (bulletSystem) delete bulletSystem;
-
-    player = new Player();
-    bulletSystem = new ParticleSystem();
-
-    // Clear & reset all values for new game play
-    asteroids.clear();
-    smallAsteroids.clear();
-    score = 0;
-    playerDeaths = 0;
-    asteroidsDestroyed = 0;
-    timer = 120.0f;
-    timesUp = false;
-
-    // Spawn Asteroids
-    for (int i = 0; i < 7; i++) {
-        glm::vec3 randomPos;
-        float distanceToPlayer = 0;
-        // Make sure asteroids spawn away from player
-        do {
-            randomPos = glm::vec3(ofRandomWidth(), ofRandomHeight(), 0);
-            distanceToPlayer = glm::distance(randomPos, player->pos);
-        } while (distanceToPlayer < minDistanceFromPlayer);
-
-        int randomSides = ofRandom(10, 20);
-        asteroids.push_back(Asteroid(randomPos, randomSides));
+    // New round with a fresh seed, recorded so it can be replayed later
+    uint64_t seed = uint64_t(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    world.stressPopulation = stressPopulation;
+    world.gravity = gravity;
+    world.steering = steering;
+    world.gravityField.theta = theta;
+    world.lodSettings = lodSettings;
+    world.start(seed, ofGetWidth(), ofGetHeight());
+    tickAccumulator = 0;
+    replaying = false;
+    quitRequested = false;
+    memoryStats.markBaseline();
+
+    Replay::Header header;
+    header.ticksPerSecond = TimerWheel::ticksPerSecond;
+    header.width = ofGetWidth();     // the size start() was given; stress worlds are sized from it
+    header.height = ofGetHeight();
+    header.seed = seed;
+    header.stressPopulation = uint32_t(world.stressPopulation);
+    header.gravity = world.gravity ? 1 : 0;
+    header.steering = uint8_t(world.steering);
+    header.theta = world.gravityField.theta;
+    header.lodNearRadius = world.lodSettings.nearRadius;
+    header.lodFarRadius = world.lodSettings.farRadius;
+    header.lodMidInterval = uint16_t(world.lodSettings.midInterval);
+    header.lodFarInterval = uint16_t(world.lodSettings.farInterval);
+    ofDirectory::createDirectory("replays", true, true);
+    if (!replayRecorder.open(ofToDataPath("replays/last.replay", true), header)) {
+        ofLogWarning("ofApp") << "could not record replay";
+    }
+}
+
+// Play back a recorded session in the window
+bool ofApp::startReplay(const std::string& path) {
+    if (!replayPlayer.open(path)) {
+        ofLogError("ofApp") << "could not open replay " << path;
+        return false;
+    }
+
+    world.stressPopulation = int(replayPlayer.header.stressPopulation);
+    world.gravity = replayPlayer.header.gravity != 0;
+    world.steering = GameWorld::Steering(replayPlayer.header.steering);
+    world.gravityField.theta = replayPlayer.header.theta;
+    world.lodSettings = Replay::lodSettings(replayPlayer.header);
+    world.start(replayPlayer.header.seed, replayPlayer.header.width, replayPlayer.header.height);
+    tickAccumulator = 0;
+    replaying = true;
+    gameState = GAMEPLAY;
+    return true;
+}
+
+void ofApp::dumpMemoryReport() {
+    std::ostringstream report;
+    memoryStats.report(report);
+    ofDirectory::createDirectory("memory", true, true);
+    std::string path = ofToDataPath("memory/memory-" + ofGetTimestampString("%Y%m%d-%H%M%S") + ".txt", true);
+    std::ofstream file(path);
+    file << report.str();
+    ofLogNotice("ofApp") << "memory at tick " << world.tick << (file ? ", saved to " + path : std::string()) << "\n" << report.str();
+}
+
+void ofApp::saveSnapshot(const std::string& path) {
+    auto start = std::chrono::steady_clock::now();
+    ofDirectory::createDirectory("snapshots", true, true);
+    if (!WorldSnapshot::save(world, path)) {
+        ofLogWarning("ofApp") << "could not save snapshot " << path;
+        return;
+    }
+    ofLogNotice("ofApp") << "saved tick " << world.tick << " to " << path << " in "
+        << std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms";
+}
+
+// Carry on playing from a saved world; the round's recording stops, since
+// the replay could no longer reach this state
+bool ofApp::restoreSnapshot(const std::string& path) {
+    auto start = std::chrono::steady_clock::now();
+    if (!WorldSnapshot::load(world, path)) {
+        ofLogError("ofApp") << "could not restore snapshot " << path;
+        return false;
     }
+    ofLogNotice("ofApp") << "restored tick " << world.tick << " from " << path << " in "
+        << std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms";
+
+    replayRecorder.close();
+    replaying = false;
+    quitRequested = false;
+    tickAccumulator = 0;
+    gameState = GAMEPLAY;
+    return true;
 }
 
 void ofApp::endGame() {
     // Clear all player actions, sounds, and flags
-    player->reset();
+    world.player->reset();
     moveLeft = false;
     moveRight = false;
     moveForward = false;
@@ -511,7 +789,7 @@ void ofApp::endGame() {
 
     // Final Score
     ofSetColor(255);
-    string finalScore = "Final Score:";
+    static const string finalScore = "Final Score:";
     ofRectangle scoreRect = textFont.getStringBoundingBox(finalScore, 0, 0);
     float scoreX = ofGetWidth() / 2 - scoreRect.getWidth() / 2;
     float scoreY = ofGetHeight() / 2 - 100;
@@ -519,7 +797,7 @@ void ofApp::endGame() {
 
     // Final Score Value
     ofSetColor(0, 255, 0);
-    string scoreValue = ofToString(score);
+    const char* scoreValue = frameArena().format("%d", world.score);
     ofRectangle scoreValueRect = titleFont.getStringBoundingBox(scoreValue, 0, 0);
     float scoreValueX = ofGetWidth() / 2 - scoreValueRect.getWidth() / 2;
     float scoreValueY = scoreY + 70;
@@ -527,7 +805,7 @@ void ofApp::endGame() {
 
     // Player Deaths
     ofSetColor(255);
-    string deathsText = "Player Deaths:";
+    static const string deathsText = "Player Deaths:";
     ofRectangle deathsRect = textFont.getStringBoundingBox(deathsText, 0, 0);
     float deathsX = ofGetWidth() / 4 - deathsRect.getWidth() / 2;
     float deathsY = scoreValueY + 70;
@@ -535,7 +813,7 @@ void ofApp::endGame() {
 
     // Player Deaths Value
     ofSetColor(0, 255, 0);
-    string deathsValue = ofToString(playerDeaths);
+    const char* deathsValue = frameArena().format("%d", world.playerDeaths);
     ofRectangle deathsValueRect = titleFont.getStringBoundingBox(deathsValue, 0, 0);
     float deathsValueX = ofGetWidth() / 4 - deathsValueRect.getWidth() / 2;
     float deathsValueY = deathsY + 70;
@@ -543,7 +821,7 @@ void ofApp::endGame() {
 
     // Asteroids Destroyed
     ofSetColor(255);
-    string asteroidsText = "Asteroids Destroyed:";
+    static const string asteroidsText = "Asteroids Destroyed:";
     ofRectangle asteroidsRect = textFont.getStringBoundingBox(asteroidsText, 0, 0);
     float asteroidsX = ofGetWidth() * 3 / 4 - asteroidsRect.getWidth() / 2;
     float asteroidsY = scoreValueY + 70;
@@ -551,7 +829,7 @@ void ofApp::endGame() {
 
     // Asteroids Destroyed Value
     ofSetColor(0, 255, 0);
-    string asteroidsValue = ofToString(asteroidsDestroyed);
+    const char* asteroidsValue = frameArena().format("%d", world.asteroidsDestroyed);
     ofRectangle asteroidsValueRect = titleFont.getStringBoundingBox(asteroidsValue, 0, 0);
     float asteroidsValueX = ofGetWidth() * 3 / 4 - asteroidsValueRect.getWidth() / 2;
     float asteroidsValueY = asteroidsY + 70;
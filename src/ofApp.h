@@ -1,12 +1,19 @@
 #pragma once
 
 #include "ofMain.h"
-#include "Shape.h"
-#include "Player.h"
-#include "Emitter.h"
-#include "Asteroid.h"
-#include "SmallAsteroid.h"
-#include "CollisionSystem.h"
+#include "GameWorld.h"
+#include "FrameArena.h"
+#include "Replay.h"
+#include "WorldHash.h"
+#include "WorldSnapshot.h"
+#include "InputPolicy.h"
+#include "DynamicResolution.h"
+#include "EffectsGovernor.h"
+#include "NetClient.h"
+#include "Telemetry.h"
+#include "FlightRecorder.h"
+#include "MemoryTracker.h"
+#include <chrono>
 
 class ofApp : public ofBaseApp {
 
@@ -29,8 +36,18 @@ public:
 	void startScreen();
 	void instructionsScreen();
 	void startGame();
+	bool startReplay(const std::string& path);
+	void saveSnapshot(const std::string& path);
+	bool restoreSnapshot(const std::string& path);
 	void endGame();
-	void spawnAsteroids();
+	int ticksDue(double frameSeconds);
+	uint8_t currentInput();
+	void playEventSounds();
+	void drawDebugOverlay();
+	void dumpMemoryReport();
+	void drawGameplayLayer();
+	void drawNetworkedGame();
+	void scaleBackground();
 
 	enum GameState {
 		START,
@@ -42,33 +59,53 @@ public:
 	bool startGameHovered;
 	bool instructionsHovered;
 	bool exitHovered;
-	float timer = 120.0f;
-	bool timesUp = false;
-	float minDistanceFromPlayer = 100.0f;
+	bool showDebugOverlay = false;
 
-	Player* player = NULL;
+	// The simulation: player, bullets, asteroids, score and round timer
+	GameWorld world;
 
 	// Movement flags
 	bool moveLeft = false;
 	bool moveRight = false;
 	bool moveForward = false;
 	bool moveBackward = false;
-
-	ParticleSystem* bulletSystem = NULL;
 	bool shooting = false;
-	float fireRate = 0.2f;
-	float lastShotTime = 0.0f;
-	float lastShootSoundTime = 0.0f;
-	float shootSoundCooldown = 0.1f;
+	bool quitRequested = false;
+
+	// Every round is recorded; a replay given on the command line is played back instead
+	ReplayRecorder replayRecorder;
+	ReplayPlayer replayPlayer;
+	std::string replayPath;
+	int replaySpeed = 1;	// playback runs this many times as fast as the recording
+	bool replaying = false;
+
+	// Fixed timestep: frame time not yet run as world ticks, and the most
+	// ticks one frame may catch up before the rest is dropped
+	double tickAccumulator = 0;
+	static const int maxTicksPerFrame = 4;
 
-	std::vector<Asteroid> asteroids;
-	std::vector<SmallAsteroid> smallAsteroids;
+	// F5 saves the world to quickSnapshotPath(), F9 puts it back; a snapshot
+	// given on the command line starts play from there
+	std::string snapshotPath;
+	std::string quickSnapshotPath() const { return ofToDataPath("snapshots/quick.snap", true); }
 
-	int score = 0;
-	int playerDeaths = 0;
-	int asteroidsDestroyed = 0;
+	// Large asteroids in an endless stress round, 0 plays the normal timed round
+	int stressPopulation = 0;
+	// Asteroids and gravity wells attract each other
+	bool gravity = false;
+	// Asteroid wander, flow field unless started with --random-walk
+	GameWorld::Steering steering = GameWorld::STEER_FLOW_FIELD;
+	// Gravity opening angle (--theta) and simulation LOD radii (--lod-near, --lod-far)
+	float theta = 0.6f;
+	SimLodSettings lodSettings;
 
-	CollisionSystem collisionSystem;
+	// With --connect, play on a localhost server instead of the local world
+	NetClient netClient;
+	uint16_t connectPort = 0;
+
+	// Bot input for soak testing, toggled with 'p'; rounds restart until the player quits
+	AutopilotPolicy autopilotPolicy;
+	bool autopilot = false;
 
 	ofSoundPlayer thrustSound;
 	ofSoundPlayer whirlSound;
@@ -76,7 +113,35 @@ public:
 	ofSoundPlayer playerHitSound;
 	ofSoundPlayer asteroidHitSound;
 
-	ofImage background;
+	ofImage backgroundSource;
+	ofImage background;		// backgroundSource scaled to the window once, redone on resize
+	OfRenderBackend renderBackend;
+
+	// Gameplay can be drawn into an offscreen layer at renderScale (0.5 - 1) of
+	// the window and stretched over the background; F4 cycles fixed scales,
+	// F6 lets dynamicResolution pick one from what the layer costs to draw,
+	// CPU time or gpuTimer's GPU time, whichever is larger
+	ofFbo gameplayLayer;
+	float renderScale = 1.0f;
+	bool dynamicScale = false;
+	DynamicResolution dynamicResolution;
+	GpuTimer gpuTimer;
+
+	// Frame, event and round records for the session, written to data/telemetry
+	TelemetryLogger telemetry;
+
+	// Last few seconds of frame timings, dumped with a snapshot to data/spikes
+	// when update or draw goes over its budget (--spike-budget)
+	FlightRecorder flightRecorder;
+
+	// Heap bytes and allocations by subsystem, sampled every frame; F7 writes
+	// the full table to data/memory
+	MemoryStats memoryStats;
+
+	// Explosion detail follows the time gameplay update and draw took last frame
+	EffectsGovernor effectsGovernor;
+	float updateSeconds = 0;
+	float drawSeconds = 0;
 
 	ofTrueTypeFont titleFont;
 	ofTrueTypeFont textFont;